@@ -5,212 +5,1174 @@
 #include <ostream>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <bitset>
+
+namespace {
+
+  /**
+   * Size of the stack buffer used by the reading of a word
+   */
+  constexpr std::size_t ReadBufferSize = 1024;
+
+  /**
+   * Under this number of slots (states times symbols), Moore is the fastest
+   * minimization of a deterministic automaton
+   */
+  constexpr std::size_t SmallMinimizeSize = 256;
+
+  /**
+   * From this number of states, a deterministic automaton is minimized in
+   * parallel when several threads are allowed
+   */
+  constexpr std::size_t ParallelMinimizeSize = 1 << 20;
+
+  /**
+   * Number of shards of the concurrent tables of the parallel constructions
+   */
+  constexpr int Shards = 64;
+
+  struct SubsetHash {
+    std::size_t operator()(const std::pmr::vector<int>& subset) const {
+      std::size_t h = subset.size() * 0x9E3779B97F4A7C15ull;
+      for(int s : subset){
+        h = (h ^ (std::size_t)s) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 29;
+      }
+      return h;
+    }
+  };
+
+  /**
+   * Replace each state by its image in a row of transitions, the pointers do
+   * not alias so the loop can be vectorized as a gather
+   */
+  void gather(int* __restrict states, const int* __restrict row, std::size_t count){
+    for(std::size_t j = 0; j < count; ++j){
+      states[j] = row[states[j]];
+    }
+  }
+
+  /**
+   * Largest bound of a repetition and deepest nesting of groups in a regular expression
+   */
+  constexpr int RegexMaxRepeat = 1000;
+  constexpr int RegexMaxDepth = 1000;
+
+  /**
+   * Largest number of nodes of a regular expression once its repetitions are
+   * expanded, which bounds its positions and the work on the shared nodes
+   */
+  constexpr std::uint64_t RegexMaxSize = 1 << 20;
+
+  /**
+   * Largest number of entries in the first, last and follow lists of the positions,
+   * and of transitions of the position automaton: the follow lists of a chain of
+   * nullable factors grow with the square of its positions
+   */
+  constexpr std::uint64_t RegexMaxOutput = 1 << 24;
+
+  /**
+   * Largest number of terms made and steps of derivation of a LazyRegex
+   */
+  constexpr std::size_t LazyMaxWork = 1 << 22;
+
+  /**
+   * Syntax tree of a regular expression, by recursive descent
+   *
+   * The children of a node are a list of cells, so that a node can be shared:
+   * the copies of a bounded repetition are the same node.
+   */
+  class RegexParser {
+  public:
+    enum Kind { Empty, Symbols, Concat, Alt, Star };
+
+    struct Node {
+      Kind kind;
+      int set;
+      int head;
+      int tail;
+      /**
+       * number of nodes with the shared children counted at each use
+       */
+      std::uint64_t size;
+    };
+
+    struct Cell {
+      int node;
+      int next;
+    };
+
+    RegexParser(std::string_view regex, std::pmr::memory_resource* resource)
+    : regex(regex), pos(0), depth(0), failed(false), nodes(resource), cells(resource), sets(resource)
+    {}
+
+    /**
+     * Parse the whole expression, returns the root or -1 on a syntax error
+     */
+    int parse(){
+      int root = alternation();
+      return (failed || pos != regex.size()) ? -1 : root;
+    }
+
+    const Node& node(int n) const { return nodes[n]; }
+    const Cell& cell(int c) const { return cells[c]; }
+    const std::bitset<256>& symbols(int set) const { return sets[set]; }
+    std::size_t countSets() const { return sets.size(); }
+    std::size_t countNodes() const { return nodes.size(); }
+
+  private:
+    bool more() const { return pos < regex.size(); }
+    char peek() const { return regex[pos]; }
+
+    int fail(){
+      failed = true;
+      return make(Empty);
+    }
+
+    int make(Kind kind, int set = -1){
+      nodes.push_back({kind,set,-1,-1,1});
+      return (int)nodes.size() - 1;
+    }
+
+    void append(int parent, int child){
+      cells.push_back({child,-1});
+      int c = (int)cells.size() - 1;
+      if(nodes[parent].tail < 0){
+        nodes[parent].head = c;
+      }else{
+        cells[nodes[parent].tail].next = c;
+      }
+      nodes[parent].tail = c;
+      // the repetitions of repetitions multiply the size
+      nodes[parent].size += nodes[child].size;
+      if(nodes[parent].size > RegexMaxSize){
+        nodes[parent].size = RegexMaxSize + 1;
+        failed = true;
+      }
+    }
+
+    int makeSet(const std::bitset<256>& set){
+      sets.push_back(set);
+      return make(Symbols,(int)sets.size() - 1);
+    }
+
+    static std::bitset<256> graphic(){
+      std::bitset<256> all;
+      for(int c = 0; c < 256; ++c){
+        all[c] = std::isgraph(c) != 0;
+      }
+      return all;
+    }
+
+    int alternation(){
+      int first = concatenation();
+      if(!more() || peek() != '|'){
+        return first;
+      }
+      int alt = make(Alt);
+      append(alt,first);
+      while(!failed && more() && peek() == '|'){
+        ++pos;
+        append(alt,concatenation());
+      }
+      return alt;
+    }
+
+    int concatenation(){
+      int concat = make(Concat);
+      while(!failed && more() && peek() != '|' && peek() != ')'){
+        append(concat,repetition());
+      }
+      return concat;
+    }
+
+    int repetition(){
+      int atom = this->atom();
+      while(!failed && more()){
+        char c = peek();
+        if(c == '*'){
+          ++pos;
+          int star = make(Star);
+          append(star,atom);
+          atom = star;
+        }else if(c == '+'){
+          ++pos;
+          atom = repeat(atom,1,-1);
+        }else if(c == '?'){
+          ++pos;
+          atom = repeat(atom,0,1);
+        }else if(c == '{'){
+          ++pos;
+          int min = 0;
+          int max = 0;
+          if(!number(min)){
+            return fail();
+          }
+          max = min;
+          if(more() && peek() == ','){
+            ++pos;
+            max = -1;
+            if(more() && peek() != '}' && !number(max)){
+              return fail();
+            }
+          }
+          if(!more() || peek() != '}' || (max >= 0 && max < min)){
+            return fail();
+          }
+          ++pos;
+          atom = repeat(atom,min,max);
+        }else{
+          break;
+        }
+      }
+      return atom;
+    }
+
+    /**
+     * min copies of a node, then max - min optional ones nested, or a star if max < 0
+     */
+    int repeat(int atom, int min, int max){
+      int concat = make(Concat);
+      for(int i = 0; i < min; ++i){
+        append(concat,atom);
+      }
+      if(max < 0){
+        int star = make(Star);
+        append(star,atom);
+        append(concat,star);
+        return concat;
+      }
+      int optional = make(Empty);
+      for(int i = min; i < max; ++i){
+        int inner = make(Concat);
+        append(inner,atom);
+        append(inner,optional);
+        int alt = make(Alt);
+        append(alt,inner);
+        append(alt,make(Empty));
+        optional = alt;
+      }
+      append(concat,optional);
+      return concat;
+    }
+
+    bool number(int& value){
+      std::size_t start = pos;
+      value = 0;
+      while(more() && std::isdigit((unsigned char)peek())){
+        value = value * 10 + (peek() - '0');
+        ++pos;
+        if(value > RegexMaxRepeat){
+          return false;
+        }
+      }
+      return pos != start;
+    }
+
+    int atom(){
+      if(!more()){
+        return fail();
+      }
+      char c = regex[pos++];
+      std::bitset<256> set;
+      switch(c){
+        case '(':{
+          if(++depth > RegexMaxDepth){
+            return fail();
+          }
+          int group = alternation();
+          --depth;
+          if(!more() || peek() != ')'){
+            return fail();
+          }
+          ++pos;
+          return group;
+        }
+        case '[':
+          return symbolClass(set) ? makeSet(set) : fail();
+        case '.':
+          return makeSet(graphic());
+        case '\\':
+          return escape(set) ? makeSet(set) : fail();
+        case '*': case '+': case '?': case '{': case ')':
+          return fail();
+        default:
+          if(!std::isgraph((unsigned char)c)){
+            return fail();
+          }
+          set[(unsigned char)c] = true;
+          return makeSet(set);
+      }
+    }
+
+    /**
+     * Read an escape after a backslash, into a set
+     */
+    bool escape(std::bitset<256>& set){
+      if(!more()){
+        return false;
+      }
+      char c = regex[pos++];
+      std::bitset<256> digits;
+      std::bitset<256> words;
+      for(int i = 0; i < 256; ++i){
+        digits[i] = std::isdigit(i) != 0;
+        words[i] = std::isalnum(i) != 0 || i == '_';
+      }
+      switch(c){
+        case 'd': set |= digits; break;
+        case 'w': set |= words; break;
+        case 'D': set |= graphic() & ~digits; break;
+        case 'W': set |= graphic() & ~words; break;
+        default:
+          if(std::string_view("\\|()[]{}*+?.^-").find(c) == std::string_view::npos){
+            return false;
+          }
+          set[(unsigned char)c] = true;
+      }
+      return true;
+    }
+
+    /**
+     * Read a class after '[', into a set
+     */
+    bool symbolClass(std::bitset<256>& set){
+      bool negated = more() && peek() == '^';
+      if(negated){
+        ++pos;
+      }
+      std::bitset<256> items;
+      bool empty = true;
+      while(more() && peek() != ']'){
+        char c = regex[pos++];
+        if(c == '\\'){
+          if(!escape(items)){
+            return false;
+          }
+        }else if(!std::isgraph((unsigned char)c)){
+          return false;
+        }else if(pos + 1 < regex.size() && peek() == '-' && regex[pos + 1] != ']'){
+          char last = regex[pos + 1];
+          pos += 2;
+          if(!std::isgraph((unsigned char)last) || last < c){
+            return false;
+          }
+          for(int i = (unsigned char)c; i <= (unsigned char)last; ++i){
+            items[i] = true;
+          }
+        }else{
+          items[(unsigned char)c] = true;
+        }
+        empty = false;
+      }
+      if(!more() || empty){
+        return false;
+      }
+      ++pos;
+      set = negated ? graphic() & ~items : items;
+      return true;
+    }
+
+    std::string_view regex;
+    std::size_t pos;
+    int depth;
+    bool failed;
+    std::pmr::vector<Node> nodes;
+    std::pmr::vector<Cell> cells;
+    std::pmr::vector<std::bitset<256>> sets;
+  };
+
+  /**
+   * Positions of a regular expression: their set of symbols, what can follow each
+   * of them, and which ones can start and end a word
+   */
+  class RegexPositions {
+  public:
+    RegexPositions(const RegexParser& parser, int root, std::pmr::memory_resource* resource)
+    : parser(parser), resource(resource), setOf(resource), follow(resource), first(resource), last(resource)
+    {
+      Info info = visit(root);
+      nullable = info.nullable;
+      first.swap(info.first);
+      last.swap(info.last);
+      if(failed){
+        return;
+      }
+      for(auto& next : follow){
+        std::sort(next.begin(),next.end());
+        next.erase(std::unique(next.begin(),next.end()),next.end());
+      }
+    }
+
+    const RegexParser& parser;
+    std::pmr::memory_resource* resource;
+    std::pmr::vector<int> setOf;
+    std::pmr::vector<std::pmr::vector<int>> follow;
+    std::pmr::vector<int> first;
+    std::pmr::vector<int> last;
+    bool nullable;
+    bool failed = false;
+
+  private:
+    std::uint64_t output = 0;
+
+    /**
+     * Count n more list entries, false once RegexMaxOutput is exceeded
+     */
+    bool spend(std::uint64_t n){
+      output += n;
+      failed = failed || output > RegexMaxOutput;
+      return !failed;
+    }
+
+    struct Info {
+      bool nullable;
+      std::pmr::vector<int> first;
+      std::pmr::vector<int> last;
+    };
+
+    /**
+     * Each visit of a shared node gives new positions
+     */
+    Info visit(int n){
+      const RegexParser::Node& node = parser.node(n);
+      Info res{true,std::pmr::vector<int>(resource),std::pmr::vector<int>(resource)};
+      if(failed){
+        return res;
+      }
+      switch(node.kind){
+        case RegexParser::Empty:
+          break;
+        case RegexParser::Symbols:
+          res.nullable = false;
+          res.first.push_back((int)setOf.size());
+          res.last.push_back((int)setOf.size());
+          setOf.push_back(node.set);
+          follow.emplace_back();
+          break;
+        case RegexParser::Star:
+          res = visit(parser.cell(node.head).node);
+          if(!spend(res.last.size() * res.first.size())){
+            break;
+          }
+          for(int p : res.last){
+            follow[p].insert(follow[p].end(),res.first.begin(),res.first.end());
+          }
+          res.nullable = true;
+          break;
+        case RegexParser::Alt:
+          res.nullable = false;
+          for(int c = node.head; c >= 0; c = parser.cell(c).next){
+            Info child = visit(parser.cell(c).node);
+            if(!spend(child.first.size() + child.last.size())){
+              break;
+            }
+            res.nullable = res.nullable || child.nullable;
+            res.first.insert(res.first.end(),child.first.begin(),child.first.end());
+            res.last.insert(res.last.end(),child.last.begin(),child.last.end());
+          }
+          break;
+        case RegexParser::Concat:
+          for(int c = node.head; c >= 0; c = parser.cell(c).next){
+            Info child = visit(parser.cell(c).node);
+            if(!spend(res.last.size() * child.first.size() + child.first.size() + child.last.size())){
+              break;
+            }
+            for(int p : res.last){
+              follow[p].insert(follow[p].end(),child.first.begin(),child.first.end());
+            }
+            if(res.nullable){
+              res.first.insert(res.first.end(),child.first.begin(),child.first.end());
+            }
+            if(child.nullable){
+              res.last.insert(res.last.end(),child.last.begin(),child.last.end());
+            }else{
+              res.last.swap(child.last);
+            }
+            res.nullable = res.nullable && child.nullable;
+          }
+          break;
+      }
+      return res;
+    }
+  };
+
+  /**
+   * Number of threads to use, 0 meaning one by core
+   */
+  unsigned resolveThreads(unsigned threads){
+    if(threads == 0){
+      threads = std::thread::hardware_concurrency();
+    }
+    return threads ? threads : 1;
+  }
+
+  /**
+   * Cut [0, n) in one chunk by thread and call work(chunk, begin, end) on each,
+   * the first chunk in the calling thread
+   */
+  template<typename F>
+  void parallelFor(unsigned threads, std::size_t n, F work){
+    std::size_t step = (n + threads - 1) / threads;
+    std::vector<std::thread> pool;
+    for(unsigned c = 1; c < threads && c * step < n; ++c){
+      pool.emplace_back(work,c,c * step,std::min(n,(c + 1) * step));
+    }
+    work(0u,std::size_t(0),std::min(n,step));
+    for(auto& t : pool){
+      t.join();
+    }
+  }
+
+  void insertSorted(std::pmr::vector<int>& list, int state){
+    list.insert(std::lower_bound(list.begin(),list.end(),state),state);
+  }
+
+  /**
+   * Refinable partition of the integers [0, n)
+   *
+   * The elements of a block are contiguous, the marked ones first. Splitting
+   * a block makes a new block of its smaller part, marked or not.
+   */
+  class Partition {
+  public:
+    Partition(std::size_t n, std::pmr::memory_resource* resource)
+    : elems(n,resource), loc(n,resource), setOf(n,0,resource), blockFirst(resource), blockMid(resource), blockEnd(resource), touched(resource)
+    {
+      for(std::size_t i = 0; i < n; ++i){
+        elems[i] = (int)i;
+        loc[i] = (int)i;
+      }
+      if(n){
+        blockFirst.push_back(0);
+        blockMid.push_back(0);
+        blockEnd.push_back((int)n);
+      }
+    }
+
+    std::size_t size() const { return blockFirst.size(); }
+    std::size_t size(int block) const { return blockEnd[block] - blockFirst[block]; }
+    int blockOf(int element) const { return setOf[element]; }
+    const int* begin(int block) const { return elems.data() + blockFirst[block]; }
+    const int* end(int block) const { return elems.data() + blockEnd[block]; }
+    int front(int block) const { return elems[blockFirst[block]]; }
+
+    void mark(int element){
+      int b = setOf[element];
+      int i = loc[element];
+      int j = blockMid[b];
+      if(i < j){
+        return;
+      }
+      if(j == blockFirst[b]){
+        touched.push_back(b);
+      }
+      elems[i] = elems[j];
+      loc[elems[i]] = i;
+      elems[j] = element;
+      loc[element] = j;
+      blockMid[b]++;
+    }
+
+    /**
+     * Split the touched blocks, onSplit(block, newBlock) is called for each split
+     */
+    template<typename F>
+    void split(F onSplit){
+      for(int b : touched){
+        if(blockMid[b] == blockEnd[b]){
+          blockMid[b] = blockFirst[b];
+          continue;
+        }
+        int nb = (int)blockFirst.size();
+        if(blockMid[b] - blockFirst[b] <= blockEnd[b] - blockMid[b]){
+          blockFirst.push_back(blockFirst[b]);
+          blockEnd.push_back(blockMid[b]);
+          blockFirst[b] = blockMid[b];
+        }else{
+          blockFirst.push_back(blockMid[b]);
+          blockEnd.push_back(blockEnd[b]);
+          blockEnd[b] = blockMid[b];
+        }
+        blockMid.push_back(blockFirst[nb]);
+        blockMid[b] = blockFirst[b];
+        for(int i = blockFirst[nb]; i < blockEnd[nb]; ++i){
+          setOf[elems[i]] = nb;
+        }
+        onSplit(b,nb);
+      }
+      touched.clear();
+    }
+
+  private:
+    std::pmr::vector<int> elems;
+    std::pmr::vector<int> loc;
+    std::pmr::vector<int> setOf;
+    std::pmr::vector<int> blockFirst;
+    std::pmr::vector<int> blockMid;
+    std::pmr::vector<int> blockEnd;
+    std::pmr::vector<int> touched;
+  };
+
+}
 
 namespace fa {
 
-  Automaton::Automaton() {}
+  Automaton::Automaton()
+  : Automaton(std::pmr::get_default_resource())
+  {}
+
+  Automaton::Automaton(std::pmr::memory_resource* resource)
+  : shared(std::allocate_shared<Storage>(std::pmr::polymorphic_allocator<Storage>(resource),resource))
+  , cachedBinState(-1), binStateKnown(false)
+  {}
+
+  Automaton::Automaton(const Automaton& other, std::pmr::memory_resource* resource)
+  : shared(other.shared), cachedBinState(other.cachedBinState), binStateKnown(other.binStateKnown)
+  {
+    if(!resource->is_equal(*other.getMemoryResource())){
+      shared = std::allocate_shared<Storage>(std::pmr::polymorphic_allocator<Storage>(resource),*other.shared,resource);
+    }
+  }
+
+  Automaton::Automaton(Automaton&& other) noexcept
+  : shared(std::move(other.shared)), cachedBinState(other.cachedBinState), binStateKnown(other.binStateKnown)
+  {
+    other.shared = emptyStorage();
+    other.binStateKnown = false;
+  }
+
+  Automaton& Automaton::operator=(Automaton&& other) noexcept{
+    shared.swap(other.shared);
+    std::swap(cachedBinState,other.cachedBinState);
+    std::swap(binStateKnown,other.binStateKnown);
+    return *this;
+  }
+
+  Automaton::Storage::Storage(std::pmr::memory_resource* resource)
+  : alphabet(resource), index(resource), ids(resource), flags(resource), edges(resource), initialStates(resource), finalStates(resource)
+  , nbTransitions(0), nbNonDeterministicKeys(0), nbFilledSlots(0)
+  {}
+
+  Automaton::Storage::Storage(const Storage& other, std::pmr::memory_resource* resource)
+  : alphabet(other.alphabet,resource), index(other.index,resource), ids(other.ids,resource), flags(other.flags,resource)
+  , edges(other.edges,resource), initialStates(other.initialStates,resource), finalStates(other.finalStates,resource)
+  , nbTransitions(other.nbTransitions), nbNonDeterministicKeys(other.nbNonDeterministicKeys), nbFilledSlots(other.nbFilledSlots)
+  {}
+
+  Automaton::Storage& Automaton::mut(){
+    if(shared.use_count() > 1){
+      std::pmr::memory_resource* resource = getMemoryResource();
+      shared = std::allocate_shared<Storage>(std::pmr::polymorphic_allocator<Storage>(resource),*shared,resource);
+    }
+    shared->words.reset();
+    return *shared;
+  }
+
+  const std::shared_ptr<Automaton::Storage>& Automaton::emptyStorage(){
+    // always shared with this variable, so never modified in place
+    static const std::shared_ptr<Storage> empty = std::make_shared<Storage>(std::pmr::new_delete_resource());
+    return empty;
+  }
+
+  std::pmr::memory_resource* Automaton::getMemoryResource() const{
+    return shared->ids.get_allocator().resource();
+  }
+
+  Automaton::TargetList::TargetList(const TargetList& other, std::pmr::memory_resource* resource)
+  : resource(resource), count(0), capacity(InlineCapacity)
+  {
+    *this = other;
+  }
+
+  Automaton::TargetList::TargetList(TargetList&& other) noexcept
+  : storage(other.storage), resource(other.resource), count(other.count), capacity(other.capacity)
+  {
+    other.count = 0;
+    other.capacity = InlineCapacity;
+  }
+
+  Automaton::TargetList::TargetList(TargetList&& other, std::pmr::memory_resource* resource)
+  : resource(resource), count(0), capacity(InlineCapacity)
+  {
+    *this = std::move(other);
+  }
+
+  Automaton::TargetList& Automaton::TargetList::operator=(const TargetList& other){
+    if(this == &other){
+      return *this;
+    }
+    if(other.count > capacity){
+      release();
+      storage.heap = static_cast<int*>(resource->allocate(other.count * sizeof(int),alignof(int)));
+      capacity = other.count;
+    }
+    std::copy(other.begin(),other.end(),data());
+    count = other.count;
+    return *this;
+  }
+
+  Automaton::TargetList& Automaton::TargetList::operator=(TargetList&& other){
+    if(this == &other){
+      return *this;
+    }
+    // the storage can only be stolen from the same memory resource
+    if(!resource->is_equal(*other.resource)){
+      return *this = other;
+    }
+    release();
+    storage = other.storage;
+    count = other.count;
+    capacity = other.capacity;
+    other.count = 0;
+    other.capacity = InlineCapacity;
+    return *this;
+  }
+
+  Automaton::TargetList::~TargetList(){
+    release();
+  }
+
+  void Automaton::TargetList::release(){
+    if(!isInline()){
+      resource->deallocate(storage.heap,capacity * sizeof(int),alignof(int));
+    }
+    capacity = InlineCapacity;
+  }
+
+  void Automaton::TargetList::push_back(int target){
+    if(count == capacity){
+      std::uint32_t grown = capacity * 2;
+      int* heap = static_cast<int*>(resource->allocate(grown * sizeof(int),alignof(int)));
+      std::copy(begin(),end(),heap);
+      release();
+      storage.heap = heap;
+      capacity = grown;
+    }
+    data()[count++] = target;
+  }
+
+  int* Automaton::TargetList::erase(int* first, int* last){
+    int* stop = std::copy(last,end(),first);
+    count = (std::uint32_t)(stop - data());
+    return first;
+  }
 
   bool Automaton::isValid() const {
     return (countSymbols() && countStates()) ? true : false;
   }
 
   bool Automaton::addSymbol(char symbol){
-	  return (!std::isgraph(symbol)) ? false: alphabet.insert(symbol).second;
+	  return (!std::isgraph(symbol) || hasSymbol(symbol)) ? false: mut().alphabet.insert(symbol).second;
   }
 
   bool Automaton::removeSymbol(char symbol){
-    if(alphabet.erase(symbol) != 1){
+    if(!hasSymbol(symbol)){
       return false;
     }
+    Storage& st = mut();
+    st.alphabet.erase(symbol);
+    binStateKnown = false;
 	// remove all transition with this symbol
-	for (auto it = transitions.begin(); it != transitions.end();){
-      if (it->first.second == symbol){
-        it = transitions.erase(it);
-	  }else{
-        ++it;
-      }
-	} 
-    
+	for(auto& out : st.edges){
+      auto it = std::lower_bound(out.begin(),out.end(),symbol,[](const Edge& e, char c){ return e.symbol < c; });
+      if(it != out.end() && it->symbol == symbol){
+        st.nbTransitions -= it->targets.size();
+        st.nbNonDeterministicKeys -= (it->targets.size() > 1);
+        st.nbFilledSlots--;
+        out.erase(it);
+      }
+	}
+
     return true;
   }
 
   bool Automaton::hasSymbol(char symbol) const{
-    return (alphabet.find(symbol) != alphabet.end());
+    const Storage& st = *shared;
+    return (st.alphabet.find(symbol) != st.alphabet.end());
   }
 
   std::size_t Automaton::countSymbols() const{
-    return alphabet.size();
+    return shared->alphabet.size();
+  }
+
+  int Automaton::appendState(int state){
+    Storage& st = mut();
+    int dense = (int)st.ids.size();
+    st.index.emplace(state,dense);
+    st.ids.push_back(state);
+    st.flags.push_back(0);
+    st.edges.emplace_back();
+    return dense;
+  }
+
+  int Automaton::appendAutomaton(const Automaton& other){
+    Storage& st = mut();
+    const Storage& from = *other.shared;
+    int offset = (int)st.ids.size();
+    st.alphabet.insert(from.alphabet.begin(),from.alphabet.end());
+    st.ids.reserve(offset + from.ids.size());
+    st.flags.resize(offset + from.ids.size(),0);
+    st.edges.reserve(offset + from.ids.size());
+    for(std::size_t d = 0; d < from.ids.size(); ++d){
+      int dense = offset + (int)d;
+      st.index.emplace(dense,dense);
+      st.ids.push_back(dense);
+      st.edges.push_back(from.edges[d]);
+      for(auto& e : st.edges.back()){
+        for(int& t : e.targets){
+          t += offset;
+        }
+      }
+    }
+    st.nbTransitions += from.nbTransitions;
+    st.nbNonDeterministicKeys += from.nbNonDeterministicKeys;
+    st.nbFilledSlots += from.nbFilledSlots;
+    binStateKnown = false;
+    return offset;
   }
 
   bool Automaton::addState(int state){
-	return (state<0) ? false : states.insert({state,std::make_pair(false,false)}).second;
+    if(state < 0 || hasState(state)){
+      return false;
+    }
+    appendState(state);
+    return true;
+  }
+
+  std::size_t Automaton::addStates(const std::vector<int>& states){
+    Storage& st = mut();
+    std::size_t added = 0;
+    st.ids.reserve(st.ids.size() + states.size());
+    st.flags.reserve(st.flags.size() + states.size());
+    st.edges.reserve(st.edges.size() + states.size());
+    for(int state : states){
+      added += addState(state);
+    }
+    return added;
   }
 
   bool Automaton::removeState(int state){
-    if(states.erase(state) != 1){
+    int dense = getStateIndex(state);
+    if(dense < 0){
       return false;
     }
-	
-	for(auto a : alphabet){
-		transitions.erase({state,a});
-	}
-    // remove all transition who have this state
-	std::set<std::pair<int,char>> rem ;
-	for(auto f : transitions){
-		for(auto a : f.second){
-			if(a == state){
-				rem.insert(f.first);
-			}
-		}
-	}
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<bool> removed(shared->ids.size(),false,&arena);
+    removed[dense] = true;
+    removeStates(removed);
+	return true;
+  }
 
-	for(auto e : rem ){
-		removeTransition(e.first,e.second,state);
-	}
+  void Automaton::removeStates(const std::pmr::vector<bool>& removed){
+    // nothing to remove, so the storage stays shared
+    if(std::find(removed.begin(),removed.end(),true) == removed.end()){
+      return;
+    }
+    Storage& st = mut();
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<int> remap(st.ids.size(),-1,&arena);
+    int count = 0;
+    for(std::size_t d = 0; d < st.ids.size(); ++d){
+      if(!removed[d]){
+        remap[d] = count++;
+      }
+    }
+
+    for(std::size_t d = 0; d < st.ids.size(); ++d){
+      if(removed[d]){
+        st.index.erase(st.ids[d]);
+        continue;
+      }
+      // drop the transitions to removed states and renumber the others
+      auto& out = st.edges[d];
+      for(auto& e : out){
+        auto last = std::remove_if(e.targets.begin(),e.targets.end(),[&](int t){ return removed[t]; });
+        e.targets.erase(last,e.targets.end());
+        for(auto& t : e.targets){
+          t = remap[t];
+        }
+      }
+      out.erase(std::remove_if(out.begin(),out.end(),[](const Edge& e){ return e.targets.empty(); }),out.end());
+
+      int nd = remap[d];
+      if(nd != (int)d){
+        st.edges[nd] = std::move(out);
+        st.ids[nd] = st.ids[d];
+        st.flags[nd] = st.flags[d];
+        st.index[st.ids[nd]] = nd;
+      }
+    }
+    st.ids.resize(count);
+    st.flags.resize(count);
+    st.edges.resize(count);
+
+    auto gone = [&](int state){ return st.index.find(state) == st.index.end(); };
+    st.initialStates.erase(std::remove_if(st.initialStates.begin(),st.initialStates.end(),gone),st.initialStates.end());
+    st.finalStates.erase(std::remove_if(st.finalStates.begin(),st.finalStates.end(),gone),st.finalStates.end());
+
+    recount();
+    binStateKnown = false;
+  }
+
+  void Automaton::recount(){
+    Storage& st = mut();
+    st.nbTransitions = 0;
+    st.nbNonDeterministicKeys = 0;
+    st.nbFilledSlots = 0;
+    for(const auto& out : st.edges){
+      for(const auto& e : out){
+        st.nbTransitions += e.targets.size();
+        st.nbNonDeterministicKeys += (e.targets.size() > 1);
+        st.nbFilledSlots += (e.symbol != fa::Epsilon);
+      }
+    }
+  }
 
-	return true;
-  } 
 
-  
   bool Automaton::hasState(int state) const{
-    return states.find(state) != states.end();
+    const Storage& st = *shared;
+    return st.index.find(state) != st.index.end();
   }
 
   std::size_t Automaton::countStates() const{
-    return states.size(); 
+    return shared->ids.size();
+  }
+
+  int Automaton::getStateIndex(int state) const{
+    const Storage& st = *shared;
+    auto it = st.index.find(state);
+    return (it == st.index.end()) ? -1 : it->second;
+  }
+
+  int Automaton::getStateId(std::size_t dense) const{
+    const Storage& st = *shared;
+    return (dense < st.ids.size()) ? st.ids[dense] : -1;
   }
 
   void Automaton::setStateInitial(int state){
-    if(hasState(state)){states.at(state).first=true;}
+    int dense = getStateIndex(state);
+    if(dense >= 0 && !(shared->flags[dense] & StateInitial)){
+      Storage& st = mut();
+      st.flags[dense] |= StateInitial;
+      insertSorted(st.initialStates,state);
+    }
   }
 
 
   bool Automaton::isStateInitial(int state) const{
-    return (hasState(state) ? states.at(state).first : false);
+    int dense = getStateIndex(state);
+    return dense >= 0 && (shared->flags[dense] & StateInitial);
   }
 
   void Automaton::setStateFinal(int state){
-    if(hasState(state)){states.at(state).second=true;}
+    int dense = getStateIndex(state);
+    if(dense >= 0 && !(shared->flags[dense] & StateFinal)){
+      Storage& st = mut();
+      st.flags[dense] |= StateFinal;
+      insertSorted(st.finalStates,state);
+    }
+    if(binStateKnown && dense == cachedBinState){binStateKnown = false;}
   }
 
   bool Automaton::isStateFinal(int state) const{
-    return (hasState(state) ? states.at(state).second : false);
+    int dense = getStateIndex(state);
+    return dense >= 0 && (shared->flags[dense] & StateFinal);
   }
 
+  const Automaton::TargetList* Automaton::findTargets(int from, char alpha) const{
+    const auto& out = shared->edges[from];
+    auto it = std::lower_bound(out.begin(),out.end(),alpha,[](const Edge& e, char c){ return e.symbol < c; });
+    return (it != out.end() && it->symbol == alpha) ? &it->targets : nullptr;
+  }
 
+  void Automaton::appendTransition(int from, char alpha, int to){
+    Storage& st = mut();
+    auto& out = st.edges[from];
+    if(out.empty()){
+      out.reserve(std::min<std::size_t>(std::max<std::size_t>(st.alphabet.size(),1),8));
+    }
+    auto it = std::lower_bound(out.begin(),out.end(),alpha,[](const Edge& e, char c){ return e.symbol < c; });
+    if(it == out.end() || it->symbol != alpha){
+      out.emplace(it,alpha,to);
+      st.nbFilledSlots += (alpha != fa::Epsilon);
+    }else{
+      it->targets.push_back(to);
+      st.nbNonDeterministicKeys += (it->targets.size() == 2);
+    }
+    st.nbTransitions++;
+    if(alpha != fa::Epsilon){refreshBinState(from);}
+  }
 
-  bool Automaton::addTransition(int from, char alpha, int to){
-	  // check all specifical case
-    if(!hasState(from) || !hasState(to) || hasTransition(from,alpha,to) || (!hasSymbol(alpha) && fa::Epsilon != alpha)){
+  bool Automaton::insertTransition(int from, char alpha, int to){
+    const TargetList* targets = findTargets(from,alpha);
+    if(targets != nullptr && std::find(targets->begin(),targets->end(),to) != targets->end()){
       return false;
     }
-    auto result = transitions.find({from,alpha});
+    appendTransition(from,alpha,to);
+    return true;
+  }
 
-    if(result == transitions.end()){
-      transitions.insert({std::make_pair(from,alpha), {to}});
-    }else{
-      result->second.push_back(to);
+  bool Automaton::eraseTransition(int from, char alpha, int to){
+    Storage& st = mut();
+    auto& out = st.edges[from];
+    auto it = std::lower_bound(out.begin(),out.end(),alpha,[](const Edge& e, char c){ return e.symbol < c; });
+    if(it == out.end() || it->symbol != alpha){
+      return false;
     }
+    auto iterator = std::find(it->targets.begin(),it->targets.end(),to);
+    if(iterator == it->targets.end()){
+      return false;
+    }
+
+	if(it->targets.size() == 1){
+		out.erase(it);
+		st.nbFilledSlots -= (alpha != fa::Epsilon);
+	}else{
+		it->targets.erase(iterator);
+		st.nbNonDeterministicKeys -= (it->targets.size() == 1);
+	}
+	st.nbTransitions--;
+	if(alpha != fa::Epsilon){refreshBinState(from);}
 
     return true;
   }
 
-  bool Automaton::removeTransition(int from, char alpha, int to){
-    if(!hasTransition(from,alpha,to)){
+  bool Automaton::addTransition(int from, char alpha, int to){
+	  // check all specifical case
+    int f = getStateIndex(from);
+    int t = getStateIndex(to);
+    if(f < 0 || t < 0 || (!hasSymbol(alpha) && fa::Epsilon != alpha)){
       return false;
     }
+    return insertTransition(f,alpha,t);
+  }
+
+  std::size_t Automaton::addTransitions(const std::vector<Transition>& list){
+    std::size_t added = 0;
+    for(const auto& tr : list){
+      added += addTransition(tr.from,tr.symbol,tr.to);
+    }
+    return added;
+  }
 
-    auto result = transitions.find({from,alpha});
-    auto iterator = std::find(result->second.begin(),result->second.end(),to);
+  std::size_t Automaton::addTransitionsByIndex(const std::vector<Transition>& list){
+    std::size_t added = 0;
+    int n = (int)shared->ids.size();
+    for(const auto& tr : list){
+      if(tr.from < 0 || tr.from >= n || tr.to < 0 || tr.to >= n || (!hasSymbol(tr.symbol) && fa::Epsilon != tr.symbol)){
+        continue;
+      }
+      added += insertTransition(tr.from,tr.symbol,tr.to);
+    }
+    return added;
+  }
 
-	if(result->second.size() == 1){
-		transitions.erase({from,alpha});
-		return true;
-	}
-	
-    return result->second.erase(iterator) != result->second.end();
+  bool Automaton::removeTransition(int from, char alpha, int to){
+    int f = getStateIndex(from);
+    int t = getStateIndex(to);
+    if(f < 0 || t < 0){
+      return false;
+    }
+    return eraseTransition(f,alpha,t);
   }
 
 
   bool Automaton::hasTransition(int from, char alpha, int to) const{
-    auto result = transitions.find({from,alpha});
-
-    
-    if(result == transitions.end()){return false;}
-    auto iterator = std::find(result->second.begin(),result->second.end(),to);
-    
+    int f = getStateIndex(from);
+    int t = getStateIndex(to);
+    if(f < 0 || t < 0){return false;}
 
-    return (iterator != result->second.end());
+    const TargetList* targets = findTargets(f,alpha);
+    return targets != nullptr && std::find(targets->begin(),targets->end(),t) != targets->end();
   }
 
   std::size_t Automaton::countTransitions() const{
-    size_t nbTransition=0;
-    
-    for(auto i = transitions.begin() ; i != transitions.end(); ++i){
-      nbTransition+= i->second.size();
-    }
+    return shared->nbTransitions;
+  }
 
-    return nbTransition;
+  std::vector<int> Automaton::sortedStates() const{
+    const Storage& st = *shared;
+    std::vector<int> order(st.ids.size());
+    for(std::size_t d = 0; d < order.size(); ++d){
+      order[d] = (int)d;
+    }
+    std::sort(order.begin(),order.end(),[&st](int lhs, int rhs){ return st.ids[lhs] < st.ids[rhs]; });
+    return order;
   }
 
   void Automaton::prettyPrint(std::ostream& os) const{
-    std::set<int> initState = getInitialState();
-    std::set<int> finalState = getFinalState();
-	
+    const Storage& st = *shared;
+    const std::pmr::vector<int>& initState = getInitialState();
+    const std::pmr::vector<int>& finalState = getFinalState();
+
 	// print initial state
     os << "Initial states:\n\t";
     for(int i : initState){
       os << i <<' ';
-    } 
+    }
 	// print final state
-    os << "\nFinal states:\n\t"; 
+    os << "\nFinal states:\n\t";
     for(int i : finalState){
       os << i <<' ';
-    } 
+    }
 	// print transitions
     os << "\nTransitions\n";
-    int firste = -1 ;
-    for (auto i = transitions.begin(); i != transitions.end(); i++) {
-      if(i->first.first != firste){
-        os << "\tFor state " << i->first.first << ":\n";
+    for (int d : sortedStates()) {
+      if(st.edges[d].empty()){
+        continue;
       }
-      
-      
-      os << "\t\tFor letter " <<(i->first.second == fa::Epsilon ? '~': i->first.second) << ": ";
-      for (size_t x = 0; x < i->second.size(); x++) {
-        os << i->second[x] << " ";
+      os << "\tFor state " << st.ids[d] << ":\n";
+      for (const auto& e : st.edges[d]) {
+        os << "\t\tFor letter " <<(e.symbol == fa::Epsilon ? '~': e.symbol) << ": ";
+        for (int t : e.targets) {
+          os << st.ids[t] << " ";
+        }
+        os << std::endl;
       }
-      os << std::endl;
-      firste = i->first.first;
     }
   }
 
   void Automaton::dotPrint(std::ostream& os) const {
+    const Storage& st = *shared;
+    std::vector<int> order = sortedStates();
     os << "digraph Automate {\n\t rankdir=LR\n";
-    for (auto i : states) {
-        if (isStateInitial(i.first) && isStateFinal(i.first)) {
-            os << "\tn" << i.first << "[shape=none label=\"\" height=0 width=0 ]\n\tn" << i.first << "->" << i.first << "\n\t" << i.first << "[shape=doublecircle]\n";
-        } else if (isStateInitial(i.first)) {
-            os << "\tn" << i.first << "[shape=none label=\"\" height=0 width=0 ]\n\tn" << i.first << "->" << i.first << "\n\t" << i.first << "[shape=circle]\n";
-        } else if (isStateFinal(i.first)) {
-            os << "\t" << i.first << "[shape=doublecircle]\n";
+    for (int d : order) {
+        int i = st.ids[d];
+        bool initial = st.flags[d] & StateInitial;
+        bool final = st.flags[d] & StateFinal;
+        if (initial && final) {
+            os << "\tn" << i << "[shape=none label=\"\" height=0 width=0 ]\n\tn" << i << "->" << i << "\n\t" << i << "[shape=doublecircle]\n";
+        } else if (initial) {
+            os << "\tn" << i << "[shape=none label=\"\" height=0 width=0 ]\n\tn" << i << "->" << i << "\n\t" << i << "[shape=circle]\n";
+        } else if (final) {
+            os << "\t" << i << "[shape=doublecircle]\n";
         }
     }
     os << "\tnode [shape = circle]\n";
-    for (auto i : states){
-      os << "\t" << i.first << std::endl ;
+    for (int d : order){
+      os << "\t" << st.ids[d] << std::endl ;
     }
-    for (auto it = transitions.begin(); it != transitions.end(); it++) {
-      for (size_t j = 0; j < it->second.size(); j++) {
-        os << "\t" << it->first.first << " -> " << it->second[j] << " [label=\"" << (it->first.second == fa::Epsilon ? '~': it->first.second) << "\"]" << std::endl;
-      } 
+    for (int d : order) {
+      for (const auto& e : st.edges[d]) {
+        for (int t : e.targets) {
+          os << "\t" << st.ids[d] << " -> " << st.ids[t] << " [label=\"" << (e.symbol == fa::Epsilon ? '~': e.symbol) << "\"]" << std::endl;
+        }
+      }
     }
     os << "}\n";
   }
 
   bool Automaton::hasEpsilonTransition () const {
-    for (auto it = transitions.begin(); it != transitions.end(); it++){
-      if (it->first.second == fa::Epsilon){
+    // Epsilon is the smallest char, so it is always the first out-edge
+    for (const auto& out : shared->edges){
+      if (!out.empty() && out.front().symbol == fa::Epsilon){
         return true;
       }
     }
@@ -218,572 +1180,3098 @@ namespace fa {
   }
 
   bool Automaton::isDeterministic() const{
-    int nbEtatInit = (int)getInitialState().size() ;
-    
-    if(nbEtatInit != 1){return false;}
-
-    for (auto it = transitions.begin(); it != transitions.end();++it){
-      if (it->second.size() > 1){
-        return false;
-      }
-    }
-
-    return true;
+    const Storage& st = *shared;
+    return st.initialStates.size() == 1 && st.nbNonDeterministicKeys == 0;
   }
 
-  bool Automaton::isComplete() const{
-    for (auto i : states){
-      for (auto itt : alphabet){
-        if (transitions.find({i.first,itt}) == transitions.end()){
-          return false;
-        }
-      }      
-    }
+  std::shared_ptr<const Automaton::WordIndex> Automaton::wordIndex() const{
+	const Storage& st = *shared;
+	std::shared_ptr<const WordIndex> cached = std::atomic_load(&st.words);
+	if(cached){
+		return cached;
+	}
 
-    return true;
-  }
-
-	void Automaton::removeNonAccessibleStates(){
-		std::set<int>  r;
-		for(auto f : states){
-			r.insert(f.first);
+	auto glados = std::make_shared<WordIndex>();
+	if(isDeterministic()){
+		std::size_t n = st.ids.size();
+		glados->start.assign(n + 1,0);
+		for(std::size_t q = 0; q < n; ++q){
+			glados->start[q + 1] = glados->start[q] + st.edges[q].size();
 		}
-		std::set<int> si = getInitialState();
-		if(si.size() == 0){
-			for(auto a : r ){
-				removeState(a);
+		glados->before.assign(glados->start[n],0);
+		glados->suffixes.assign(n,0);
+		glados->initial = getStateIndex(st.initialStates.front());
+
+		// depth-first search, the counts of a state are done after its successors
+		std::vector<unsigned char> color(n,0);
+		std::vector<std::pair<int,std::size_t>> stack;
+		bool ranked = true;
+		color[glados->initial] = 1;
+		stack.emplace_back(glados->initial,0);
+		while(ranked && !stack.empty()){
+			int q = stack.back().first;
+			std::size_t i = stack.back().second++;
+			const auto& out = st.edges[q];
+			if(i < out.size()){
+				int to = out[i].targets.front();
+				if(out[i].symbol == Epsilon || color[to] == 1){
+					ranked = false;
+				}else if(color[to] == 0){
+					color[to] = 1;
+					stack.emplace_back(to,0);
+				}
+				continue;
 			}
-			addState(0);
-			setStateInitial(0);
-			return;
-		}
-		
-		std::set<int> visited;
-		for(int lo : si){
-			DepthFirstSearch(false,visited,lo);
+			std::size_t count = (st.flags[q] & StateFinal) ? 1 : 0;
+			for(std::size_t e = 0; e < out.size(); ++e){
+				glados->before[glados->start[q] + e] = count;
+				std::size_t suffixes = glados->suffixes[out[e].targets.front()];
+				// a state has no more words than the initial state, so the total overflows too
+				if(suffixes > std::numeric_limits<std::size_t>::max() - count){
+					ranked = false;
+				}
+				count += suffixes;
+			}
+			glados->suffixes[q] = count;
+			color[q] = 2;
+			stack.pop_back();
 		}
-		std::set<int> notVisited;
-		std::set_difference(begin(r),end(r),begin(visited),end(visited),inserter(notVisited,end(notVisited)));
-		
-		for(auto fe:notVisited){
-			removeState(fe);
+		glados->ranked = ranked;
+	}
+	std::shared_ptr<const WordIndex> res = glados;
+	std::atomic_store(&st.words,res);
+	return res;
+  }
+
+  std::size_t Automaton::countWords() const{
+	std::shared_ptr<const WordIndex> words = wordIndex();
+	return words->ranked ? words->suffixes[words->initial] : 0;
+  }
+
+  std::optional<std::size_t> Automaton::wordToIndex(std::string_view word) const{
+	std::shared_ptr<const WordIndex> words = wordIndex();
+	if(!words->ranked){
+		return std::nullopt;
+	}
+	const Storage& st = *shared;
+	int q = words->initial;
+	std::size_t index = 0;
+	for(char c : word){
+		const auto& out = st.edges[q];
+		auto it = std::lower_bound(out.begin(),out.end(),c,[](const Edge& e, char symbol){ return e.symbol < symbol; });
+		if(it == out.end() || it->symbol != c){
+			return std::nullopt;
 		}
+		index += words->before[words->start[q] + (it - out.begin())];
+		q = it->targets.front();
+	}
+	if(!(st.flags[q] & StateFinal)){
+		return std::nullopt;
+	}
+	return index;
+  }
 
+  std::optional<std::string> Automaton::indexToWord(std::size_t index) const{
+	std::shared_ptr<const WordIndex> words = wordIndex();
+	if(!words->ranked || index >= words->suffixes[words->initial]){
+		return std::nullopt;
+	}
+	const Storage& st = *shared;
+	int q = words->initial;
+	std::string word;
+	while(!(index == 0 && (st.flags[q] & StateFinal))){
+		// the last edge with no more words before it than the index
+		auto first = words->before.begin() + words->start[q];
+		auto last = words->before.begin() + words->start[q + 1];
+		auto it = std::upper_bound(first,last,index) - 1;
+		index -= *it;
+		const Edge& e = st.edges[q][it - first];
+		word.push_back(e.symbol);
+		q = e.targets.front();
 	}
+	return word;
+  }
 
-	void Automaton::removeNonCoAccessibleStates(){
-		// mirror removeNonAccessibleStates and mirror remove all NonCoAccessiblesState
-		*this=createMirror(*this);
-		removeNonAccessibleStates();
-		*this=createMirror(*this);
-	}
-	
-	bool Automaton::DepthFirstSearch(bool emptyChoice,std::set<int>& v,int s )const{
-		v.insert(s);
-		bool var = true;
-		for( auto i : transitions){
-			if(i.first.first == s){
-				for(int x : i.second){
-					if(emptyChoice){
-						if(isStateFinal(x)){
-							return false;
-						}
-						if(var && v.find(x) == v.end()){
-						
-							var = DepthFirstSearch(true,v,x);
-						}
+  bool Automaton::isComplete() const{
+    const Storage& st = *shared;
+    return st.nbFilledSlots == st.ids.size() * st.alphabet.size();
+  }
 
-					}else{
-						if(v.find(x) == v.end()){
-							DepthFirstSearch(false,v,x);
-						}
+	std::pmr::vector<int> Automaton::denseInitialStates(std::pmr::memory_resource* resource) const{
+		const Storage& st = *shared;
+		std::pmr::vector<int> res(resource);
+		res.reserve(st.initialStates.size());
+		for(std::size_t d = 0; d < st.flags.size(); ++d){
+			if(st.flags[d] & StateInitial){
+				res.push_back((int)d);
+			}
+		}
+		return res;
+	}
+
+	std::pmr::vector<bool> Automaton::reachableFrom(const std::pmr::vector<int>& from, std::pmr::memory_resource* resource) const{
+		const Storage& st = *shared;
+		std::pmr::vector<bool> visited(st.ids.size(),false,resource);
+		std::pmr::vector<int> stack(resource);
+		for(int s : from){
+			if(!visited[s]){
+				visited[s] = true;
+				stack.push_back(s);
+			}
+		}
+		while(!stack.empty()){
+			int s = stack.back();
+			stack.pop_back();
+			for(const auto& e : st.edges[s]){
+				for(int t : e.targets){
+					if(!visited[t]){
+						visited[t] = true;
+						stack.push_back(t);
 					}
 				}
 			}
 		}
+		return visited;
+	}
+
+	void Automaton::removeNonAccessibleStates(){
+		const Storage& st = *shared;
+		std::pmr::monotonic_buffer_resource arena;
+		if(st.initialStates.empty()){
+			std::pmr::vector<bool> all(st.ids.size(),true,&arena);
+			removeStates(all);
+			addState(0);
+			setStateInitial(0);
+			return;
+		}
 
-		return var;
+		std::pmr::vector<bool> visited = reachableFrom(denseInitialStates(&arena),&arena);
+		visited.flip();
+		removeStates(visited);
 	}
 
-	
+	void Automaton::removeNonCoAccessibleStates(){
+		const Storage& st = *shared;
+		std::pmr::monotonic_buffer_resource arena;
+		if(st.finalStates.empty()){
+			std::pmr::vector<bool> all(st.ids.size(),true,&arena);
+			removeStates(all);
+			addState(0);
+			setStateFinal(0);
+			return;
+		}
 
-	bool Automaton::isLanguageEmpty() const{
-		bool init = false;
-		bool final = false ;												
-		std::vector<int> tabStateInit;	
-		std::vector<int> tabStateFinal;					
-		for(auto i : states){
-			if(i.second.first){
-				tabStateInit.push_back(i.first);
-				init = true;
-			}
-			if(i.second.second){
-				tabStateFinal.push_back(i.first);
-				final = true;
-			}
-		}
-		
-		for(auto ff : tabStateInit){
-			for(auto aa : tabStateFinal){
-				if(ff == aa){
-					return false;
+		// predecessors of each dense state, stored contiguously
+		std::pmr::vector<int> start(st.ids.size() + 1,0,&arena);
+		for(const auto& out : st.edges){
+			for(const auto& e : out){
+				for(int t : e.targets){
+					start[t + 1]++;
+				}
+			}
+		}
+		for(std::size_t d = 0; d < st.ids.size(); ++d){
+			start[d + 1] += start[d];
+		}
+		std::pmr::vector<int> preds(start.back(),&arena);
+		std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+		for(std::size_t d = 0; d < st.ids.size(); ++d){
+			for(const auto& e : st.edges[d]){
+				for(int t : e.targets){
+					preds[fill[t]++] = (int)d;
 				}
 			}
 		}
-		// check if one state is initial and final
-		if(!init || !final){
-			return true;
+
+		std::pmr::vector<bool> visited(st.ids.size(),false,&arena);
+		std::pmr::vector<int> stack(&arena);
+		for(std::size_t d = 0; d < st.flags.size(); ++d){
+			if(st.flags[d] & StateFinal){
+				visited[d] = true;
+				stack.push_back((int)d);
+			}
+		}
+		while(!stack.empty()){
+			int s = stack.back();
+			stack.pop_back();
+			for(int i = start[s]; i < start[s + 1]; ++i){
+				if(!visited[preds[i]]){
+					visited[preds[i]] = true;
+					stack.push_back(preds[i]);
+				}
+			}
 		}
-		
-		std::set<int> v;
-		for(auto x : tabStateInit){
-			if(!DepthFirstSearch(true,v,x)){
+		visited.flip();
+		removeStates(visited);
+	}
+
+	bool Automaton::isLanguageEmpty() const{
+		const Storage& st = *shared;
+		// check if one final state is accessible
+		std::pmr::monotonic_buffer_resource arena;
+		std::pmr::vector<bool> visited = reachableFrom(denseInitialStates(&arena),&arena);
+		for(std::size_t d = 0; d < st.flags.size(); ++d){
+			if(visited[d] && (st.flags[d] & StateFinal)){
 				return false;
-			}	
+			}
 		}
-		
+
 		return true;
 	}
 
   bool Automaton::hasEmptyIntersectionWith(const Automaton& other) const{
-	  return createProduct(*this,other).isLanguageEmpty();
+	  std::pmr::monotonic_buffer_resource arena;
+	  return createProduct(*this,other,&arena).isLanguageEmpty();
   }
 
-	std::set<int> Automaton::readSymbols(const std::set<int> sete,char a) const{
-		std::set<int> res;
-		
-		for(auto i : sete){
-			for(auto st : states){
-				if(hasTransition(i,a,st.first)){
-					res.insert(st.first);
+	void Automaton::readSymbol(const std::pmr::vector<int>& from, char a, std::pmr::vector<int>& to, std::pmr::vector<bool>& mark) const{
+		to.clear();
+		for(int s : from){
+			const TargetList* targets = findTargets(s,a);
+			if(targets == nullptr){
+				continue;
+			}
+			for(int t : *targets){
+				if(!mark[t]){
+					mark[t] = true;
+					to.push_back(t);
 				}
 			}
 		}
-
-		return res;
+		for(int t : to){
+			mark[t] = false;
+		}
 	}
 
-	std::set<int> Automaton::getInitialState() const{
-		std::set<int> sI;
-		for(auto i : states){
-			if(i.second.first){
-				sI.insert(i.first);
+	std::pmr::vector<int> Automaton::readDense(const std::string& word, std::pmr::memory_resource* resource) const{
+		std::pmr::vector<int> current = denseInitialStates(resource);
+		std::pmr::vector<int> next(resource);
+		std::pmr::vector<bool> mark(shared->ids.size(),false,resource);
+		for(auto a : word){
+			readSymbol(current,a,next,mark);
+			current.swap(next);
+			if(current.empty()){
+				break;
 			}
 		}
-		return sI;
+		return current;
 	}
 
-	std::set<int> Automaton::getFinalState() const{
-		std::set<int> sI;
-		for(auto i : states){
-			if(i.second.second){
-				sI.insert(i.first);
-			}
-		}
-		return sI;
+	const std::pmr::vector<int>& Automaton::getInitialState() const{
+		return shared->initialStates;
+	}
+
+	const std::pmr::vector<int>& Automaton::getFinalState() const{
+		return shared->finalStates;
 	}
 
   std::set<int> Automaton::readString(const std::string& word) const{
-	std::set<int> sI = getInitialState();
-	for(auto a : word){
-		sI = readSymbols(sI,a);		
+	std::set<int> sI;
+	char buffer[ReadBufferSize];
+	std::pmr::monotonic_buffer_resource arena(buffer,sizeof(buffer));
+	for(int d : readDense(word,&arena)){
+		sI.insert(shared->ids[d]);
 	}
     return sI;
   }
 
   bool Automaton::match(const std::string& word) const{
-	std::set<int> res = readString(word);
-
-	for(auto a : states){
-		for(auto x : res){
-			if(a.first == x){
-				if(a.second.second){return true;}
-			}
-		}
+	char buffer[ReadBufferSize];
+	std::pmr::monotonic_buffer_resource arena(buffer,sizeof(buffer));
+	for(int d : readDense(word,&arena)){
+		if(shared->flags[d] & StateFinal){return true;}
 	}
 
 	return false;
   }
 
   bool Automaton::isIncludedIn(const Automaton& other) const {
-    fa::Automaton CleanMate = other;
-    for(auto alpha : alphabet) {
+    // the complement and the product are only temporaries
+    std::pmr::monotonic_buffer_resource arena;
+    fa::Automaton CleanMate(other,&arena);
+    for(auto alpha : shared->alphabet) {
       if(!CleanMate.hasSymbol(alpha)) {
         CleanMate.addSymbol(alpha);
       }
     }
-	
-    return hasEmptyIntersectionWith(fa::Automaton::createComplement(CleanMate));
+    // the determinization of the complement starts from the bisimulation quotient
+    CleanMate.complement();
+
+    return createProduct(createBisimulationQuotient(*this,&arena),CleanMate,&arena).isLanguageEmpty();
   }
 
   Automaton Automaton::createMirror(const Automaton& automaton){
-    fa::Automaton bigBrother;
-    bigBrother.states=automaton.states;
-    bigBrother.alphabet=automaton.alphabet;
+    fa::Automaton bigBrother(automaton.getMemoryResource());
+    const Storage& st = *automaton.shared;
+    Storage& mirror = bigBrother.mut();
+    mirror.alphabet=st.alphabet;
+    mirror.index=st.index;
+    mirror.ids=st.ids;
+    mirror.edges.resize(st.ids.size());
+    // initial and final states are swapped
+    mirror.initialStates=st.finalStates;
+    mirror.finalStates=st.initialStates;
+    mirror.flags.reserve(st.flags.size());
+    for(auto f : st.flags){
+      mirror.flags.push_back((unsigned char)(((f & StateInitial) ? StateFinal : 0) | ((f & StateFinal) ? StateInitial : 0)));
+    }
+
+    for(std::size_t d = 0; d < st.edges.size(); ++d){
+      for(const auto& e : st.edges[d]){
+        for(int t : e.targets){
+          bigBrother.appendTransition(t,e.symbol,(int)d);
+        }
+      }
+    }
+
+    return bigBrother;
+  }
+
+  Automaton Automaton::createMirror(Automaton&& automaton){
+    automaton.mirror();
+    return std::move(automaton);
+  }
 
-    for( auto it : automaton.transitions){
-      for(auto i = 0u ; i < it.second.size(); ++i){
-        bigBrother.addTransition(it.second[i],it.first.second,it.first.first);
+  void Automaton::mirror(){
+    Storage& st = mut();
+    // keep the transitions aside, then refill the emptied out-edges backward
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<Transition> reversed(&arena);
+    reversed.reserve(st.nbTransitions);
+    for(std::size_t d = 0; d < st.edges.size(); ++d){
+      for(const auto& e : st.edges[d]){
+        for(int t : e.targets){
+          reversed.push_back(Transition{t,e.symbol,(int)d});
+        }
       }
     }
+    for(auto& out : st.edges){
+      out.clear();
+    }
+    st.nbTransitions = 0;
+    st.nbNonDeterministicKeys = 0;
+    st.nbFilledSlots = 0;
+    binStateKnown = false;
+    for(const auto& tr : reversed){
+      appendTransition(tr.from,tr.symbol,tr.to);
+    }
 
-	std::set<int> finale = bigBrother.getFinalState();
-	std::set<int> init = bigBrother.getInitialState();
+    // initial and final states are swapped
+    st.initialStates.swap(st.finalStates);
+    for(auto& f : st.flags){
+      f = (unsigned char)(((f & StateInitial) ? StateFinal : 0) | ((f & StateFinal) ? StateInitial : 0));
+    }
+  }
 
-	for(auto a : finale){
-		auto i = bigBrother.states.find(a);
-		if(!i->second.first){
-			i->second.first = true;
-			i->second.second = false;
+	bool Automaton::isBinState(int state) const{
+		const Storage& st = *shared;
+		if(st.flags[state] & StateFinal){
+			return false;
+		}
+		bool loop = false;
+		for(const auto& e : st.edges[state]){
+			if(e.symbol == fa::Epsilon){
+				continue;
+			}
+			for(auto m : e.targets){
+				if(m != state){
+					return false;
+				}
+			}
+			loop = true;
 		}
+		return loop;
 	}
 
-	for(auto a : init){
-		auto i = bigBrother.states.find(a);
-		if(!i->second.second){
-			i->second.first = false;
-			i->second.second = true;
+	void Automaton::refreshBinState(int state){
+		if(!binStateKnown){
+			return;
+		}
+		if(state == cachedBinState){
+			binStateKnown = isBinState(state);
+		}else if((cachedBinState < 0 || state < cachedBinState) && isBinState(state)){
+			cachedBinState = state;
 		}
 	}
 
-
-    return bigBrother;
-  }
-
 	int Automaton::findBinState() const{
-		for( auto x : states){
-			std::set<int> res;
-			for(auto a : transitions){
-				for( auto f : alphabet){
-					if(a.first.first == x.first && a.first.second == f && !x.second.second){
-						for(auto m : a.second){
-							res.insert(m);
-						}
-					}
-				}
-			}
-			if(res.size() == 1 ){
-				for (auto g : res){
-					if(g == x.first){return g;}
+		if(!binStateKnown){
+			cachedBinState = -1;
+			for(std::size_t d = 0; d < shared->ids.size(); ++d){
+				if(isBinState((int)d)){
+					cachedBinState = (int)d;
+					break;
 				}
 			}
+			binStateKnown = true;
 		}
 
-
-		return -1;
+		return cachedBinState;
 	}
 
   Automaton Automaton::createComplete(const Automaton& automaton){
-    if (automaton.isComplete()){
-      return automaton;
-    }
-
     fa::Automaton create = automaton;
+    create.complete();
+    return create;
+  }
 
-    int binState = create.findBinState();
+  Automaton Automaton::createComplete(Automaton&& automaton){
+    automaton.complete();
+    return std::move(automaton);
+  }
+
+  void Automaton::complete(){
+    if (isComplete()){
+      return;
+    }
+
+    Storage& st = mut();
+    std::size_t n = st.ids.size();
+    int binState = findBinState();
 	if(binState < 0){
-		binState = 0;
-		while(create.hasState(binState)){
-			binState++;
+		int id = 0;
+		while(hasState(id)){
+			id++;
 		}
-		create.addState(binState);
-	}
-	for(auto a : create.states){
-		if(a.first == binState){
-			a.second.second = true;
-		} 
+		binState = appendState(id);
 	}
 
-    for (auto itt : create.alphabet){
-      create.addTransition(binState,itt,binState);
+    for (auto itt : st.alphabet){
+      insertTransition(binState,itt,binState);
     }
 
-    for (auto i : automaton.states){
-      for (auto itt : automaton.alphabet){
-        if (automaton.transitions.find({i.first,itt}) == automaton.transitions.end()){
-          create.addTransition(i.first,itt,binState);
+    for (std::size_t d = 0; d < n; ++d){
+      for (auto itt : st.alphabet){
+        if (findTargets((int)d,itt) == nullptr){
+          appendTransition((int)d,itt,binState);
         }
-      } 
+      }
     }
-
-
-    return create;
   }
 
 
   Automaton Automaton::createComplement(const Automaton& automaton){
     fa::Automaton  glados = automaton;
-	if(!glados.isDeterministic()){glados = createDeterministic(glados);}
-    if(!glados.isComplete()){glados = createComplete(glados);}
-	for(auto &sta : glados.states){(sta.second.second) ? sta.second.second = false: sta.second.second = true;}
+    glados.complement();
     return glados;
   }
 
+  Automaton Automaton::createComplement(Automaton&& automaton){
+    automaton.complement();
+    return std::move(automaton);
+  }
+
+  void Automaton::complement(){
+	determinize();
+	complete();
+	Storage& st = mut();
+	st.finalStates.clear();
+	for(std::size_t d = 0; d < st.flags.size(); ++d){
+		st.flags[d] ^= StateFinal;
+		if(st.flags[d] & StateFinal){st.finalStates.push_back(st.ids[d]);}
+	}
+	std::sort(st.finalStates.begin(),st.finalStates.end());
+	binStateKnown = false;
+  }
 
 
-  Automaton Automaton::createProduct(const Automaton& lhs, const Automaton& rhs){
-		fa::Automaton bosch ;
-		std::set_intersection(begin(lhs.alphabet),end(lhs.alphabet),begin(rhs.alphabet),end(rhs.alphabet),inserter(bosch.alphabet,end(bosch.alphabet)));
-		
-		int compt =  0; 
-		std::map<std::pair<int,int>,int> visited;
-
-		for(auto l : lhs.states){
-			for(auto r : rhs.states){
-				if(l.second.first && r.second.first){
-					visited.insert({std::make_pair(l.first,r.first),compt});
-					bosch.addState(compt);
-					bosch.setStateInitial(compt);
-					compt++;
-				}
-			}
-		}
-
-		for(auto bd : visited){
-			for(auto a : bosch.alphabet){
-				std::set<int> stockG = lhs.readSymbols({bd.first.first},a);
-				std::set<int> stockD = rhs.readSymbols({bd.first.second},a);
-				for(auto p : stockG){
-					for(auto v : stockD){
-						auto findKey = visited.find(std::make_pair(p,v));
-						if(findKey == visited.end()){
-							visited.insert({std::make_pair(p,v),compt});
-							bosch.addState(compt);
-							bosch.addTransition(bd.second,a,compt);
-							compt++;
-						}else{
-							bosch.addTransition(bd.second,a,findKey->second);
-						}
-					}
+
+  Automaton Automaton::createUnion(const Automaton& lhs, const Automaton& rhs){
+	fa::Automaton glados(lhs.getMemoryResource());
+	for(const Automaton* operand : {&lhs,&rhs}){
+		int offset = glados.appendAutomaton(*operand);
+		const Storage& st = *operand->shared;
+		for(std::size_t d = 0; d < st.flags.size(); ++d){
+			if(st.flags[d] & StateInitial){
+				glados.setStateInitial(offset + (int)d);
+			}
+			if(st.flags[d] & StateFinal){
+				glados.setStateFinal(offset + (int)d);
+			}
+		}
+	}
+	return glados;
+  }
+
+  Automaton Automaton::createConcatenation(const Automaton& lhs, const Automaton& rhs){
+	fa::Automaton glados(lhs.getMemoryResource());
+	const Storage& left = *lhs.shared;
+	const Storage& right = *rhs.shared;
+	glados.appendAutomaton(lhs);
+	int offset = glados.appendAutomaton(rhs);
+
+	bool emptyLeft = false;
+	bool emptyRight = false;
+	for(int state : left.initialStates){
+		emptyLeft = emptyLeft || lhs.isStateFinal(state);
+	}
+	for(int state : right.initialStates){
+		emptyRight = emptyRight || rhs.isStateFinal(state);
+	}
+
+	// the start of rhs: its initial state, or a new one with all their transitions
+	int start;
+	if(right.initialStates.size() == 1){
+		start = offset + rhs.getStateIndex(right.initialStates.front());
+	}else{
+		start = glados.appendState((int)glados.countStates());
+		for(int state : right.initialStates){
+			for(const auto& e : right.edges[rhs.getStateIndex(state)]){
+				for(int t : e.targets){
+					glados.insertTransition(start,e.symbol,offset + t);
 				}
 			}
 		}
+	}
 
-		for(auto bd : visited){
-			if(lhs.isStateFinal(bd.first.first) && rhs.isStateFinal(bd.first.second)){
-				bosch.setStateFinal(bd.second);
+	// reaching a final state of lhs may also be starting rhs
+	for(std::size_t d = 0; d < left.edges.size(); ++d){
+		for(const auto& e : left.edges[d]){
+			for(int t : e.targets){
+				if(left.flags[t] & StateFinal){
+					glados.insertTransition((int)d,e.symbol,start);
+				}
 			}
 		}
-		if(!bosch.countStates()){
-			bosch.addState(0);
+	}
+
+	for(std::size_t d = 0; d < left.flags.size(); ++d){
+		if(left.flags[d] & StateInitial){
+			glados.setStateInitial((int)d);
 		}
-		if(!bosch.countSymbols()){
-			bosch.addSymbol('a');
+		if(emptyRight && (left.flags[d] & StateFinal)){
+			glados.setStateFinal((int)d);
 		}
-
-
-		return bosch;
+	}
+	for(std::size_t d = 0; d < right.flags.size(); ++d){
+		if(right.flags[d] & StateFinal){
+			glados.setStateFinal(offset + (int)d);
+		}
+	}
+	if(emptyLeft){
+		glados.setStateInitial(start);
+	}
+	if(emptyRight){
+		glados.setStateFinal(start);
+	}
+	return glados;
   }
 
+  Automaton Automaton::createKleeneStar(const Automaton& other){
+	fa::Automaton glados(other.getMemoryResource());
+	const Storage& st = *other.shared;
+	glados.appendAutomaton(other);
 
-  Automaton Automaton::createDeterministic(const Automaton& other){
-	if(other.isDeterministic()){return other;}
-	fa::Automaton moulinex;
-	moulinex.alphabet = other.alphabet;
+	// the new start has the transitions of the initial states,
+	// and reaching a final state may also be starting again
+	int start = glados.appendState((int)glados.countStates());
+	glados.setStateInitial(start);
+	glados.setStateFinal(start);
+	for(std::size_t d = 0; d < st.edges.size(); ++d){
+		for(const auto& e : st.edges[d]){
+			for(int t : e.targets){
+				if(st.flags[d] & StateInitial){
+					glados.insertTransition(start,e.symbol,t);
+				}
+				if(st.flags[t] & StateFinal){
+					glados.insertTransition((int)d,e.symbol,start);
+					if(st.flags[d] & StateInitial){
+						glados.insertTransition(start,e.symbol,start);
+					}
+				}
+			}
+		}
+		if(st.flags[d] & StateFinal){
+			glados.setStateFinal((int)d);
+		}
+	}
+	return glados;
+  }
 
-	std::map<int,std::set<int>> bd;
-	int compt = 0;
+  Automaton::DawgBuilder::DawgBuilder()
+  : path(1,PathState{false,{}}), edgeStart(1,0), frozen(0,FrozenHash{this},FrozenEqual{this})
+  {}
 
-	bd.insert({compt,other.getInitialState()});
-	moulinex.addState(compt);
-	moulinex.setStateInitial(compt);
-	compt++;
+  std::size_t Automaton::DawgBuilder::FrozenHash::operator()(int state) const{
+	std::size_t h = builder->finals[state];
+	for(int e = builder->edgeStart[state]; e < builder->edgeStart[state + 1]; ++e){
+		h = (h ^ (unsigned char)builder->edgeSymbols[e]) * 0x9E3779B97F4A7C15ull;
+		h = (h ^ (std::size_t)builder->edgeTargets[e]) * 0xFF51AFD7ED558CCDull;
+		h ^= h >> 29;
+	}
+	return h;
+  }
 
-	for(auto bdd : bd){
-		for(auto a : moulinex.alphabet){
-			std::set<int> stock = other.readSymbols(bdd.second,a);
-			bool var = false;
-			for(auto key : bd){
-				if(key.second == stock){
-					moulinex.addTransition(bdd.first,a,key.first);
-					var = true;
-				}
-			}
-			if(!var){
-				bd.insert({compt,stock});
-				moulinex.addState(compt);
-				moulinex.addTransition(bdd.first,a,compt);
-				compt++;
-			}
+  bool Automaton::DawgBuilder::FrozenEqual::operator()(int lhs, int rhs) const{
+	const DawgBuilder& b = *builder;
+	if(b.finals[lhs] != b.finals[rhs] || b.edgeStart[lhs + 1] - b.edgeStart[lhs] != b.edgeStart[rhs + 1] - b.edgeStart[rhs]){
+		return false;
+	}
+	for(int i = b.edgeStart[lhs], j = b.edgeStart[rhs]; i < b.edgeStart[lhs + 1]; ++i, ++j){
+		if(b.edgeSymbols[i] != b.edgeSymbols[j] || b.edgeTargets[i] != b.edgeTargets[j]){
+			return false;
 		}
 	}
-	
-	for(auto bdd :bd){
-		for(auto aze : bdd.second){
-			if(other.isStateFinal(aze)){
-				moulinex.setStateFinal(bdd.first);
-				break;
-			}
+	return true;
+  }
+
+  bool Automaton::DawgBuilder::add(std::string_view word){
+	if(word < previous){
+		return false;
+	}
+	if(word == previous && !path.empty() && path.back().final){
+		return true;
+	}
+	for(char c : word){
+		if(!std::isgraph((unsigned char)c)){
+			return false;
 		}
 	}
 
+	// the path after the common prefix can not change any more
+	std::size_t prefix = 0;
+	while(prefix < word.size() && prefix < previous.size() && word[prefix] == previous[prefix]){
+		++prefix;
+	}
+	freeze(prefix);
+	for(std::size_t i = prefix; i < word.size(); ++i){
+		path.back().edges.emplace_back(word[i],-1);
+		path.push_back(PathState{false,{}});
+	}
+	path.back().final = true;
+	previous.assign(word.begin(),word.end());
+	return true;
+  }
 
-	
+  void Automaton::DawgBuilder::freeze(std::size_t depth){
+	while(path.size() > depth + 1){
+		int state = freeze(path.back());
+		path.pop_back();
+		path.back().edges.back().second = state;
+	}
+  }
 
-	return moulinex;
+  int Automaton::DawgBuilder::freeze(const PathState& state){
+	// appended, then removed if an equivalent state is already frozen
+	int candidate = (int)finals.size();
+	finals.push_back(state.final);
+	for(const auto& e : state.edges){
+		edgeSymbols.push_back(e.first);
+		edgeTargets.push_back(e.second);
+	}
+	edgeStart.push_back((int)edgeSymbols.size());
+	auto res = frozen.insert(candidate);
+	if(!res.second){
+		finals.pop_back();
+		edgeStart.pop_back();
+		edgeSymbols.resize(edgeStart.back());
+		edgeTargets.resize(edgeStart.back());
+	}
+	return *res.first;
   }
 
-  std::vector<std::pair<char,std::vector<int>>> Automaton::rempliTableauMoor(const Automaton& copy,std::vector<std::pair<char,std::vector<int>>> n,std::vector<int> sta){
-	for(char a : copy.alphabet){
-		  std::vector<int> ligne;
-		  for(int cmp = 0 ;  cmp < (int)sta.size() ; ++cmp){
-			  auto fi = copy.transitions.find({sta[cmp],a});
-			  int cmp2 = 0;
-			  for(auto edf : sta){
-				  if(edf == fi->second[0]){
-					  ligne.push_back(n[0].second[cmp2]);
-				  }
-				  cmp2++;
-			  }
-		  }
-		  
-		  n.push_back(std::make_pair(a,ligne));
-	  }
-	return n;
-  }
-
-	std::vector<int> Automaton::returnLigne0Tab(std::vector<std::pair<char,std::vector<int>>> tabAvant){
-		std::vector<int> res;
-		std::vector<std::vector<int>> tabtab;
-		size_t size = tabAvant[0].second.size();
-		for(size_t i = 0 ; i < size;++i){
-			std::vector<int> column;
-			for(auto a :tabAvant){
-				for(size_t e = 0; e < a.second.size();e++){
-					if(e == i){
-						column.push_back(a.second[e]);
-					}
-				}
+  Automaton Automaton::DawgBuilder::finish(){
+	freeze(0);
+	int root = freeze(path.front());
+
+	fa::Automaton R2D2;
+	for(char c : edgeSymbols){
+		R2D2.mut().alphabet.insert(c);
+	}
+	if(!R2D2.countSymbols()){
+		R2D2.addSymbol('a');
+	}
+	std::vector<int> number(finals.size(),-1);
+	std::vector<int> order;
+	auto lookup = [&](int state){
+		if(number[state] < 0){
+			number[state] = (int)order.size();
+			order.push_back(state);
+			R2D2.appendState(number[state]);
+			if(finals[state]){
+				R2D2.setStateFinal(number[state]);
 			}
-			tabtab.push_back(column);
 		}
-	
-		std::vector<std::pair<int,std::vector<int>>> column;
-		int compt = 1;
-		for(auto a : tabtab){
-			if(column.size() == 0){
-				res.push_back(1);
-				column.push_back({compt,a});
-				compt++;
+		return number[state];
+	};
+	R2D2.setStateInitial(lookup(root));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		for(int e = edgeStart[order[i]]; e < edgeStart[order[i] + 1]; ++e){
+			int to = lookup(edgeTargets[e]);
+			R2D2.appendTransition((int)i,edgeSymbols[e],to);
+		}
+	}
+	return R2D2;
+  }
+
+  Automaton Automaton::createSuffixAutomaton(std::string_view text, std::vector<std::size_t>* occurrences){
+	fa::Automaton R2D2;
+	for(char c : text){
+		if(!std::isgraph((unsigned char)c)){
+			return Automaton();
+		}
+		R2D2.mut().alphabet.insert(c);
+	}
+	if(!R2D2.countSymbols()){
+		R2D2.addSymbol('a');
+	}
+
+	// length of the longest word of each state, suffix link and end positions
+	std::vector<int> len(1,0);
+	std::vector<int> link(1,-1);
+	std::vector<std::size_t> endpos(1,0);
+	len.reserve(2 * text.size() + 1);
+	link.reserve(2 * text.size() + 1);
+	endpos.reserve(2 * text.size() + 1);
+	R2D2.appendState(0);
+	auto target = [&](int from, char c){
+		const TargetList* targets = R2D2.findTargets(from,c);
+		return targets != nullptr ? targets->front() : -1;
+	};
+
+	int last = 0;
+	for(char c : text){
+		int cur = R2D2.appendState((int)len.size());
+		len.push_back(len[last] + 1);
+		link.push_back(0);
+		endpos.push_back(1);
+		int p = last;
+		while(p >= 0 && target(p,c) < 0){
+			R2D2.appendTransition(p,c,cur);
+			p = link[p];
+		}
+		if(p >= 0){
+			int q = target(p,c);
+			if(len[p] + 1 == len[q]){
+				link[cur] = q;
 			}else{
-				bool var = true;
-				for(auto c : column){
-					if(a == c.second){
-						res.push_back(c.first);
-						var = false;
+				// q also holds longer words, the shorter ones move to a copy of it
+				int clone = R2D2.appendState((int)len.size());
+				len.push_back(len[p] + 1);
+				link.push_back(link[q]);
+				endpos.push_back(0);
+				Storage& st = R2D2.mut();
+				st.edges[clone] = st.edges[q];
+				st.nbTransitions += st.edges[clone].size();
+				st.nbFilledSlots += st.edges[clone].size();
+				while(p >= 0){
+					auto& out = st.edges[p];
+					auto it = std::lower_bound(out.begin(),out.end(),c,[](const Edge& e, char symbol){ return e.symbol < symbol; });
+					if(it->targets.front() != q){
+						break;
 					}
+					*it->targets.begin() = clone;
+					p = link[p];
 				}
-				if(var){
-					res.push_back(compt);
-					column.push_back({compt,a});
-			 		compt++;
-				}
+				link[q] = clone;
+				link[cur] = clone;
 			}
+		}
+		last = cur;
+	}
+
+	Storage& st = R2D2.mut();
+	st.flags[0] |= StateInitial;
+	st.initialStates.push_back(0);
+	for(std::size_t d = 0; d < st.ids.size(); ++d){
+		st.flags[d] |= StateFinal;
+		st.finalStates.push_back((int)d);
+	}
+	R2D2.binStateKnown = false;
 
+	if(occurrences != nullptr){
+		// the end positions of a state are given to its suffix link, longest states first
+		std::vector<int> byLength(text.size() + 2,0);
+		for(int l : len){
+			byLength[l + 1]++;
 		}
-		
-		return res;
+		for(std::size_t l = 1; l < byLength.size(); ++l){
+			byLength[l] += byLength[l - 1];
+		}
+		std::vector<int> order(len.size());
+		for(std::size_t d = 0; d < len.size(); ++d){
+			order[byLength[len[d]]++] = (int)d;
+		}
+		for(std::size_t i = order.size(); i-- > 1;){
+			endpos[link[order[i]]] += endpos[order[i]];
+		}
+		endpos[0] = text.size() + 1;
+		*occurrences = std::move(endpos);
 	}
+	return R2D2;
+  }
 
-	void Automaton::printMinimalMooreStepTab(std::vector<std::pair<char,std::vector<int>>> nZero,int& count){
-		std::cout << std::endl;
-	  for(auto a : nZero){
-		  std::cout << "|";
-		  if(a.first == '~'){
-			  std::cout << a.first << count;
-			  count++;
-		  }else{
-			  std::cout << a.first << " ";
-		  }
-		  std::cout << "|";
-		  for(auto e : a.second){
-			  std::cout << e << "|";
-		  }
-		  std::cout << std::endl;
-	  }
-	  std::cout << std::endl;
+  Automaton Automaton::fromRegex(std::string_view regex){
+	std::pmr::monotonic_buffer_resource arena;
+	RegexParser parser(regex,&arena);
+	int root = parser.parse();
+	if(root < 0){
+		return fa::Automaton();
+	}
+	RegexPositions positions(parser,root,&arena);
+	if(positions.failed){
+		return fa::Automaton();
+	}
 
+	// the symbols of each set of the expression
+	std::pmr::vector<std::pmr::vector<char>> symbols(parser.countSets(),&arena);
+	fa::Automaton R2D2;
+	for(std::size_t set = 0; set < symbols.size(); ++set){
+		for(int c = 0; c < 256; ++c){
+			if(parser.symbols((int)set)[c]){
+				symbols[set].push_back((char)c);
+				R2D2.mut().alphabet.insert((char)c);
+			}
+		}
+	}
+	if(!R2D2.countSymbols()){
+		R2D2.addSymbol('a');
+	}
+	std::uint64_t transitions = 0;
+	for(int p : positions.first){
+		transitions += symbols[positions.setOf[p]].size();
+	}
+	for(const auto& next : positions.follow){
+		for(int p : next){
+			transitions += symbols[positions.setOf[p]].size();
+		}
+	}
+	if(transitions > RegexMaxOutput){
+		return fa::Automaton();
 	}
 
-  Automaton Automaton::createMinimalMoore(const Automaton& other){
-	  fa::Automaton copy =  other;
-	  copy.removeNonAccessibleStates();
-	  copy = createComplete(copy);
-	  copy = createDeterministic(copy);
-	  fa::Automaton R2D2;
-	  R2D2.alphabet = copy.alphabet;
-	  
-	  std::vector<int> sta;
-	  std::vector<std::pair<char,std::vector<int>>> nZero;
-	  std::vector<std::pair<char,std::vector<int>>> nPlusUn;
-		
-	  std::vector<int> res;
-	  for(auto e : copy.states){	  
-		  sta.push_back(e.first);
-		  if(copy.isStateFinal(e.first)){
-			  res.push_back(2);
-		  }else{
-			  res.push_back(1);
-		  }
-	  }
+	// the state 0 is before the first symbol, the state p + 1 after the position p
+	for(std::size_t state = 0; state <= positions.setOf.size(); ++state){
+		R2D2.appendState((int)state);
+	}
+	R2D2.setStateInitial(0);
+	if(positions.nullable){
+		R2D2.setStateFinal(0);
+	}
+	for(int p : positions.last){
+		R2D2.setStateFinal(p + 1);
+	}
+	auto link = [&](int from, const std::pmr::vector<int>& targets){
+		for(int p : targets){
+			for(char c : symbols[positions.setOf[p]]){
+				R2D2.appendTransition(from,c,p + 1);
+			}
+		}
+	};
+	link(0,positions.first);
+	for(std::size_t p = 0; p < positions.follow.size(); ++p){
+		link((int)p + 1,positions.follow[p]);
+	}
 
-	  nZero.push_back(std::make_pair('~',res));
-	  nZero=  rempliTableauMoor(copy,nZero,sta);
-	  nPlusUn.push_back(std::make_pair('~',returnLigne0Tab(nZero)));
-	  nPlusUn=  rempliTableauMoor(copy,nPlusUn,sta);
+	return R2D2;
+  }
 
+  Automaton Automaton::createProduct(const Automaton& lhs, const Automaton& rhs){
+		return createProduct(lhs,rhs,lhs.getMemoryResource());
+  }
 
-	  while(nZero[0].second != nPlusUn[0].second){
-		  nZero=nPlusUn;
-		  std::vector<std::pair<char,std::vector<int>>> newe;
-		  newe.push_back(std::make_pair('~',returnLigne0Tab(nZero)));
-		  newe =  rempliTableauMoor(copy,newe,sta);
-		  nPlusUn = newe;
-	  }
+  Automaton Automaton::createProduct(const Automaton& lhs, const Automaton& rhs, std::pmr::memory_resource* resource){
+		fa::Automaton bosch(resource);
+		std::pmr::monotonic_buffer_resource arena;
+		std::set_intersection(begin(lhs.shared->alphabet),end(lhs.shared->alphabet),begin(rhs.shared->alphabet),end(rhs.shared->alphabet),inserter(bosch.mut().alphabet,bosch.mut().alphabet.end()));
 
+		// pairs of dense states, numbered in breadth-first order
+		long long width = (long long)rhs.shared->ids.size();
+		std::pmr::unordered_map<long long,int> visited(&arena);
+		std::pmr::vector<std::pair<int,int>> pairs(&arena);
 
-	for(int i = 0 ; i < (int)nPlusUn[0].second.size();++i){
-			R2D2.addState(nPlusUn[0].second[i]);
-			if(copy.isStateInitial(sta[i])){
-				R2D2.setStateInitial(nPlusUn[0].second[i]);
+		auto lookup = [&](int l, int r){
+			auto res = visited.emplace((long long)l * width + r,(int)pairs.size());
+			if(res.second){
+				pairs.emplace_back(l,r);
+				bosch.appendState(res.first->second);
 			}
-			if(copy.isStateFinal(sta[i])){
-				R2D2.setStateFinal(nPlusUn[0].second[i]);
+			return res.first->second;
+		};
+
+		for(int l : lhs.denseInitialStates(&arena)){
+			for(int r : rhs.denseInitialStates(&arena)){
+				bosch.setStateInitial(lookup(l,r));
 			}
-	}
-	
-	for(auto ligne : nPlusUn){
-		if(ligne.first == '~'){continue;}
-		for(int i = 0 ; i < (int)ligne.second.size();++i){
-			R2D2.addTransition(nPlusUn[0].second[i],ligne.first,ligne.second[i]);
 		}
-	}
-	if(!R2D2.getInitialState().size()){
-		for(auto zaz : R2D2.states){
-			R2D2.setStateInitial(zaz.first);
-			break;
-		}
-	}
-	  return R2D2;
-  }
 
+		for(std::size_t i = 0; i < pairs.size(); ++i){
+			const auto& outL = lhs.shared->edges[pairs[i].first];
+			const auto& outR = rhs.shared->edges[pairs[i].second];
+			// both lists are sorted by symbol
+			auto itL = outL.begin();
+			auto itR = outR.begin();
+			while(itL != outL.end() && itR != outR.end()){
+				if(itL->symbol < itR->symbol){
+					++itL;
+				}else if(itR->symbol < itL->symbol){
+					++itR;
+				}else{
+					if(itL->symbol != fa::Epsilon){
+						for(int p : itL->targets){
+							for(int v : itR->targets){
+								int to = lookup(p,v);
+								bosch.appendTransition((int)i,itL->symbol,to);
+							}
+						}
+					}
+					++itL;
+					++itR;
+				}
+			}
+		}
 
-	Automaton Automaton::createMinimalBrzozowski(const Automaton& other){
-		fa::Automaton thermomix = other;
-		
-		thermomix = createMirror(thermomix);
-		
-		thermomix = createDeterministic(thermomix);
-	
-		thermomix = createMirror(thermomix);
-		thermomix = createDeterministic(thermomix);
-	
-		thermomix = createComplete(thermomix);
-	
-		
-		return thermomix;
-	}
-
-	
+		for(std::size_t i = 0; i < pairs.size(); ++i){
+			if((lhs.shared->flags[pairs[i].first] & StateFinal) && (rhs.shared->flags[pairs[i].second] & StateFinal)){
+				bosch.setStateFinal((int)i);
+			}
+		}
+		if(!bosch.countStates()){
+			bosch.addState(0);
+		}
+		if(!bosch.countSymbols()){
+			bosch.addSymbol('a');
+		}
+
+
+		return bosch;
+  }
+
+
+  Automaton Automaton::createProduct(const std::vector<Automaton>& automata, ProductOptions options){
+	std::pmr::memory_resource* resource = automata.empty() ? std::pmr::get_default_resource() : automata.front().getMemoryResource();
+	unsigned threads = resolveThreads(options.threads);
+	// the threads can not share a resource which is not thread safe
+	std::pmr::memory_resource* work = (threads > 1) ? std::pmr::new_delete_resource() : resource;
+
+	auto reduce = [&](const Automaton& operand){
+		fa::Automaton res(operand,work);
+		if(res.isLanguageEmpty()){
+			return res;
+		}
+		if(options.minimize && res.isDeterministic()){
+			return createMinimalValmari(res);
+		}
+		res.removeNonAccessibleStates();
+		res.removeNonCoAccessibleStates();
+		return options.minimize ? createBisimulationQuotient(res,work) : res;
+	};
+
+	auto empty = [&](){
+		fa::Automaton glados(resource);
+		if(!automata.empty()){
+			glados.mut().alphabet = automata.front().shared->alphabet;
+			for(const auto& operand : automata){
+				auto& alphabet = glados.mut().alphabet;
+				for(auto it = alphabet.begin(); it != alphabet.end();){
+					it = operand.hasSymbol(*it) ? std::next(it) : alphabet.erase(it);
+				}
+			}
+		}
+		if(!glados.countSymbols()){
+			glados.addSymbol('a');
+		}
+		glados.addState(0);
+		glados.setStateInitial(0);
+		return glados;
+	};
+	auto anyEmpty = [](const std::vector<Automaton>& list){
+		return std::any_of(list.begin(),list.end(),[](const Automaton& operand){ return operand.isLanguageEmpty(); });
+	};
+
+	ProductStats stats;
+	auto record = [&](std::size_t states){
+		stats.products++;
+		stats.largestProduct = std::max(stats.largestProduct,states);
+	};
+	auto finish = [&](fa::Automaton res){
+		if(options.stats != nullptr){
+			*options.stats = stats;
+		}
+		return res;
+	};
+
+	std::vector<Automaton> current(automata.size());
+	parallelFor(threads,automata.size(),[&](unsigned, std::size_t first, std::size_t last){
+		for(std::size_t i = first; i < last; ++i){
+			current[i] = reduce(automata[i]);
+		}
+	});
+	if(current.empty() || anyEmpty(current)){
+		return finish(empty());
+	}
+
+	auto bySize = [](const Automaton& lhs, const Automaton& rhs){ return lhs.countStates() < rhs.countStates(); };
+	if(options.order == ProductOrder::Smallest){
+		while(current.size() > 1){
+			std::stable_sort(current.begin(),current.end(),bySize);
+			std::vector<Automaton> next((current.size() + 1) / 2);
+			std::vector<std::size_t> sizes(current.size() / 2);
+			parallelFor(threads,current.size() / 2,[&](unsigned, std::size_t first, std::size_t last){
+				for(std::size_t i = first; i < last; ++i){
+					fa::Automaton product = createProduct(current[2 * i],current[2 * i + 1],work);
+					sizes[i] = product.countStates();
+					next[i] = reduce(product);
+				}
+			});
+			for(std::size_t size : sizes){
+				record(size);
+			}
+			if(current.size() % 2){
+				next.back() = std::move(current.back());
+			}
+			if(anyEmpty(next)){
+				return finish(empty());
+			}
+			current.swap(next);
+		}
+	}else{
+		std::stable_sort(current.begin(),current.end(),bySize);
+		fa::Automaton bigBrother = std::move(current.front());
+		std::vector<bool> used(current.size(),false);
+		for(std::size_t step = 1; step < current.size(); ++step){
+			std::size_t best = 0;
+			std::size_t bestOverlap = 0;
+			for(std::size_t i = 1; i < current.size(); ++i){
+				if(used[i]){
+					continue;
+				}
+				std::size_t overlap = 0;
+				for(char a : bigBrother.shared->alphabet){
+					overlap += current[i].hasSymbol(a);
+				}
+				if(best == 0 || overlap < bestOverlap){
+					best = i;
+					bestOverlap = overlap;
+				}
+			}
+			used[best] = true;
+			fa::Automaton product = createProduct(bigBrother,current[best],work);
+			record(product.countStates());
+			bigBrother = reduce(product);
+			if(bigBrother.isLanguageEmpty()){
+				return finish(empty());
+			}
+		}
+		current.front() = std::move(bigBrother);
+	}
+
+	return finish(fa::Automaton(current.front(),resource));
+  }
+
+  Automaton Automaton::createProductParallel(const Automaton& lhs, const Automaton& rhs, unsigned threads){
+	threads = resolveThreads(threads);
+	if(threads == 1){
+		return createProduct(lhs,rhs);
+	}
+	fa::Automaton bosch(lhs.getMemoryResource());
+	std::pmr::monotonic_buffer_resource arena;
+	std::set_intersection(begin(lhs.shared->alphabet),end(lhs.shared->alphabet),begin(rhs.shared->alphabet),end(rhs.shared->alphabet),inserter(bosch.mut().alphabet,bosch.mut().alphabet.end()));
+
+	// pairs of dense states get a temporary number when found, in a sharded table
+	struct Shard {
+		std::mutex lock;
+		std::unordered_map<long long,int> index;
+	};
+	// what a thread found during a level: the new pairs, and the transitions
+	struct NewPair {
+		int number;
+		int l;
+		int r;
+	};
+	struct Step {
+		int from;
+		char symbol;
+		int to;
+	};
+	struct Found {
+		std::vector<NewPair> pairs;
+		std::vector<Step> steps;
+	};
+	long long width = (long long)rhs.shared->ids.size();
+	std::vector<Shard> shards(Shards);
+	std::vector<Found> found(threads);
+	std::atomic<int> nbPairs(0);
+
+	auto intern = [&](int l, int r, Found& mine){
+		long long key = (long long)l * width + r;
+		Shard& shard = shards[(((std::size_t)key * 0x9E3779B97F4A7C15ull) >> 32) % Shards];
+		std::lock_guard<std::mutex> guard(shard.lock);
+		auto res = shard.index.emplace(key,0);
+		if(res.second){
+			res.first->second = nbPairs.fetch_add(1);
+			mine.pairs.push_back({res.first->second,l,r});
+		}
+		return res.first->second;
+	};
+
+	std::pmr::vector<int> initials(&arena);
+	for(int l : lhs.denseInitialStates(&arena)){
+		for(int r : rhs.denseInitialStates(&arena)){
+			initials.push_back(intern(l,r,found[0]));
+		}
+	}
+
+	// level-synchronous breadth-first search, each thread expands a part of the level
+	std::pmr::vector<std::pair<int,int>> pairs(&arena);
+	std::pmr::vector<int> level(&arena);
+	for(;;){
+		pairs.resize(nbPairs.load());
+		level.clear();
+		for(auto& mine : found){
+			for(const auto& p : mine.pairs){
+				pairs[p.number] = {p.l,p.r};
+				level.push_back(p.number);
+			}
+			mine.pairs.clear();
+		}
+		if(level.empty()){
+			break;
+		}
+
+		parallelFor(threads,level.size(),[&](unsigned chunk, std::size_t first, std::size_t last){
+			Found& mine = found[chunk];
+			for(std::size_t i = first; i < last; ++i){
+				int from = level[i];
+				const auto& outL = lhs.shared->edges[pairs[from].first];
+				const auto& outR = rhs.shared->edges[pairs[from].second];
+				// both lists are sorted by symbol
+				auto itL = outL.begin();
+				auto itR = outR.begin();
+				while(itL != outL.end() && itR != outR.end()){
+					if(itL->symbol < itR->symbol){
+						++itL;
+					}else if(itR->symbol < itL->symbol){
+						++itR;
+					}else{
+						if(itL->symbol != fa::Epsilon){
+							for(int p : itL->targets){
+								for(int v : itR->targets){
+									mine.steps.push_back({from,itL->symbol,intern(p,v,mine)});
+								}
+							}
+						}
+						++itL;
+						++itR;
+					}
+				}
+			}
+		});
+	}
+
+	// merge the transitions by origin, a pair keeps the order of its transitions
+	std::size_t total = pairs.size();
+	std::pmr::vector<int> start(total + 1,0,&arena);
+	for(const auto& mine : found){
+		for(const auto& step : mine.steps){
+			start[step.from + 1]++;
+		}
+	}
+	for(std::size_t i = 0; i < total; ++i){
+		start[i + 1] += start[i];
+	}
+	std::pmr::vector<const Step*> steps(start[total],&arena);
+	std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+	for(const auto& mine : found){
+		for(const auto& step : mine.steps){
+			steps[fill[step.from]++] = &step;
+		}
+	}
+
+	// numbered in breadth-first order as in the sequential product
+	std::pmr::vector<int> number(total,-1,&arena);
+	std::pmr::vector<int> order(&arena);
+	auto lookup = [&](int pair){
+		if(number[pair] < 0){
+			number[pair] = (int)order.size();
+			order.push_back(pair);
+			bosch.appendState(number[pair]);
+		}
+		return number[pair];
+	};
+	for(int pair : initials){
+		bosch.setStateInitial(lookup(pair));
+	}
+	for(std::size_t i = 0; i < order.size(); ++i){
+		for(int e = start[order[i]]; e < start[order[i] + 1]; ++e){
+			int to = lookup(steps[e]->to);
+			bosch.appendTransition((int)i,steps[e]->symbol,to);
+		}
+	}
+
+	for(std::size_t i = 0; i < order.size(); ++i){
+		const auto& pair = pairs[order[i]];
+		if((lhs.shared->flags[pair.first] & StateFinal) && (rhs.shared->flags[pair.second] & StateFinal)){
+			bosch.setStateFinal((int)i);
+		}
+	}
+	if(!bosch.countStates()){
+		bosch.addState(0);
+	}
+	if(!bosch.countSymbols()){
+		bosch.addSymbol('a');
+	}
+
+	return bosch;
+  }
+
+  Automaton Automaton::createDeterministic(const Automaton& other){
+	if(other.isDeterministic()){return other;}
+	fa::Automaton moulinex(other.getMemoryResource());
+	moulinex.mut().alphabet = other.shared->alphabet;
+
+	// the subsets are made of states of the bisimulation quotient, when it is smaller
+	std::pmr::monotonic_buffer_resource arena;
+	fa::Automaton quotient = createBisimulationQuotient(other,&arena);
+	const Automaton& source = (quotient.countStates() < other.countStates()) ? quotient : other;
+
+	// subsets of dense states, numbered in breadth-first order
+	std::pmr::map<std::pmr::vector<int>,int> bd(&arena);
+	std::pmr::vector<const std::pmr::vector<int>*> subsets(&arena);
+
+	auto lookup = [&](std::pmr::vector<int>& stock){
+		std::sort(stock.begin(),stock.end());
+		auto res = bd.emplace(stock,(int)subsets.size());
+		if(res.second){
+			subsets.push_back(&res.first->first);
+			int compt = moulinex.appendState(res.first->second);
+			for(int s : stock){
+				if(source.shared->flags[s] & StateFinal){
+					moulinex.setStateFinal(compt);
+					break;
+				}
+			}
+		}
+		return res.first->second;
+	};
+
+	std::pmr::vector<int> stock = source.denseInitialStates(&arena);
+	moulinex.setStateInitial(lookup(stock));
+
+	std::pmr::vector<bool> mark(source.shared->ids.size(),false,&arena);
+	for(std::size_t i = 0; i < subsets.size(); ++i){
+		for(auto a : moulinex.shared->alphabet){
+			source.readSymbol(*subsets[i],a,stock,mark);
+			int to = lookup(stock);
+			moulinex.appendTransition((int)i,a,to);
+		}
+	}
+
+	return moulinex;
+  }
+
+  Automaton Automaton::createDeterministicParallel(const Automaton& other, unsigned threads){
+	threads = resolveThreads(threads);
+	if(threads == 1 || other.isDeterministic()){
+		return createDeterministic(other);
+	}
+
+	// the subsets are made of states of the bisimulation quotient, when it is smaller
+	std::pmr::monotonic_buffer_resource arena;
+	fa::Automaton quotient = createBisimulationQuotient(other,&arena);
+	const Automaton& source = (quotient.countStates() < other.countStates()) ? quotient : other;
+	std::pmr::vector<char> symbols(source.shared->alphabet.begin(),source.shared->alphabet.end(),&arena);
+	std::size_t k = symbols.size();
+
+	// a subset found in a shard is numbered locally by discovery,
+	// its temporary number is local * Shards + shard
+	struct Shard {
+		std::mutex lock;
+		std::unordered_map<std::pmr::vector<int>,int,SubsetHash> index;
+		std::vector<const std::pmr::vector<int>*> subsets;
+	};
+	// the subsets to expand, and the expanded ones: the number then the k targets
+	struct Worker {
+		std::mutex lock;
+		std::deque<std::pair<int,const std::pmr::vector<int>*>> work;
+		std::vector<int> edges;
+	};
+	std::vector<Shard> shards(Shards);
+	std::vector<Worker> workers(threads);
+	std::atomic<std::size_t> pending(0);
+
+	auto intern = [&](Worker& self, std::pmr::vector<int>& stock){
+		std::sort(stock.begin(),stock.end());
+		int s = (int)(SubsetHash()(stock) % Shards);
+		Shard& shard = shards[s];
+		std::pair<int,const std::pmr::vector<int>*> item;
+		{
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto res = shard.index.emplace(stock,(int)shard.subsets.size() * Shards + s);
+			if(!res.second){
+				return res.first->second;
+			}
+			shard.subsets.push_back(&res.first->first);
+			item = {res.first->second,&res.first->first};
+		}
+		pending.fetch_add(1);
+		std::lock_guard<std::mutex> guard(self.lock);
+		self.work.push_back(item);
+		return item.first;
+	};
+
+	std::pmr::vector<int> stock = source.denseInitialStates(&arena);
+	int initial = intern(workers[0],stock);
+
+	parallelFor(threads,threads,[&](unsigned, std::size_t begin, std::size_t end){
+		for(std::size_t w = begin; w < end; ++w){
+			Worker& self = workers[w];
+			std::pmr::vector<int> next;
+			std::pmr::vector<bool> mark(source.shared->ids.size(),false);
+			for(;;){
+				// the newest subset of its own queue, or the oldest of another one
+				std::pair<int,const std::pmr::vector<int>*> item(-1,nullptr);
+				{
+					std::lock_guard<std::mutex> guard(self.lock);
+					if(!self.work.empty()){
+						item = self.work.back();
+						self.work.pop_back();
+					}
+				}
+				for(unsigned v = 1; item.second == nullptr && v < threads; ++v){
+					Worker& victim = workers[(w + v) % threads];
+					std::lock_guard<std::mutex> guard(victim.lock);
+					if(!victim.work.empty()){
+						item = victim.work.front();
+						victim.work.pop_front();
+					}
+				}
+				if(item.second == nullptr){
+					if(pending.load() == 0){
+						break;
+					}
+					std::this_thread::yield();
+					continue;
+				}
+
+				self.edges.push_back(item.first);
+				for(char a : symbols){
+					source.readSymbol(*item.second,a,next,mark);
+					self.edges.push_back(intern(self,next));
+				}
+				pending.fetch_sub(1);
+			}
+		}
+	});
+
+	// the temporary numbers become contiguous, then the states are numbered in
+	// breadth-first order as in the sequential construction
+	std::pmr::vector<int> offset(Shards + 1,0,&arena);
+	for(int s = 0; s < Shards; ++s){
+		offset[s + 1] = offset[s] + (int)shards[s].subsets.size();
+	}
+	auto global = [&](int temporary){ return offset[temporary % Shards] + temporary / Shards; };
+	std::size_t total = offset[Shards];
+	std::pmr::vector<int> delta(total * k,&arena);
+	for(const auto& worker : workers){
+		for(std::size_t i = 0; i < worker.edges.size(); i += k + 1){
+			int from = global(worker.edges[i]);
+			for(std::size_t a = 0; a < k; ++a){
+				delta[from * k + a] = global(worker.edges[i + 1 + a]);
+			}
+		}
+	}
+	std::pmr::vector<bool> final(total,false,&arena);
+	for(int s = 0; s < Shards; ++s){
+		for(std::size_t i = 0; i < shards[s].subsets.size(); ++i){
+			for(int d : *shards[s].subsets[i]){
+				if(source.shared->flags[d] & StateFinal){
+					final[offset[s] + i] = true;
+					break;
+				}
+			}
+		}
+	}
+
+	fa::Automaton moulinex(other.getMemoryResource());
+	moulinex.mut().alphabet = other.shared->alphabet;
+	std::pmr::vector<int> number(total,-1,&arena);
+	std::pmr::vector<int> order(&arena);
+	auto lookup = [&](int subset){
+		if(number[subset] < 0){
+			number[subset] = (int)order.size();
+			order.push_back(subset);
+			moulinex.appendState(number[subset]);
+			if(final[subset]){
+				moulinex.setStateFinal(number[subset]);
+			}
+		}
+		return number[subset];
+	};
+	moulinex.setStateInitial(lookup(global(initial)));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		for(std::size_t a = 0; a < k; ++a){
+			int to = lookup(delta[order[i] * k + a]);
+			moulinex.appendTransition((int)i,symbols[a],to);
+		}
+	}
+
+	return moulinex;
+  }
+
+  Automaton Automaton::createDeterministic(Automaton&& other){
+	other.determinize();
+	return std::move(other);
+  }
+
+  void Automaton::determinize(){
+	// the subset construction needs the original, the result takes over its place
+	if(!isDeterministic()){*this = createDeterministic(*this);}
+  }
+
+  Automaton Automaton::createMinimalMoore(const Automaton& other){
+	  // the intermediate automata live in the arena, only R2D2 uses the resource of other
+	  std::pmr::monotonic_buffer_resource arena;
+	  fa::Automaton copy(other,&arena);
+	  copy.removeNonAccessibleStates();
+	  copy.complete();
+	  copy.determinize();
+	  fa::Automaton R2D2(other.getMemoryResource());
+	  R2D2.mut().alphabet = copy.shared->alphabet;
+
+	  std::size_t n = copy.shared->ids.size();
+	  std::pmr::vector<char> symbols(copy.shared->alphabet.begin(),copy.shared->alphabet.end(),&arena);
+
+	  // classes are numbered from 1, in order of first appearance
+	  std::pmr::vector<int> classes(n,&arena);
+	  for(std::size_t d = 0; d < n; ++d){
+		  classes[d] = (copy.shared->flags[d] & StateFinal) ? 2 : 1;
+	  }
+	  std::size_t nbClasses = 0;
+	  std::pmr::vector<int> next(n,&arena);
+	  std::pmr::vector<int> signature(symbols.size() + 1,&arena);
+
+	  for(;;){
+		  // one arena per round, the signatures of a round are dropped at once
+		  std::pmr::monotonic_buffer_resource round;
+		  std::pmr::map<std::pmr::vector<int>,int> signatures(&round);
+		  for(std::size_t d = 0; d < n; ++d){
+			  signature[0] = classes[d];
+			  for(std::size_t a = 0; a < symbols.size(); ++a){
+				  signature[a + 1] = classes[copy.findTargets((int)d,symbols[a])->front()];
+			  }
+			  next[d] = signatures.emplace(signature,(int)signatures.size() + 1).first->second;
+		  }
+		  classes.swap(next);
+		  if(signatures.size() == nbClasses){
+			  break;
+		  }
+		  nbClasses = signatures.size();
+	  }
+
+	// classes appear in increasing order, so the dense index of a class is its number minus one
+	for(std::size_t d = 0; d < n; ++d){
+			if(!R2D2.hasState(classes[d])){
+				R2D2.appendState(classes[d]);
+				for(std::size_t a = 0; a < symbols.size(); ++a){
+					R2D2.appendTransition(classes[d] - 1,symbols[a],classes[copy.findTargets((int)d,symbols[a])->front()] - 1);
+				}
+			}
+			if(copy.shared->flags[d] & StateInitial){
+				R2D2.setStateInitial(classes[d]);
+			}
+			if(copy.shared->flags[d] & StateFinal){
+				R2D2.setStateFinal(classes[d]);
+			}
+	}
+
+	if(R2D2.getInitialState().empty() && R2D2.countStates()){
+		R2D2.setStateInitial(R2D2.shared->ids[0]);
+	}
+	  return R2D2;
+  }
+
+
+	Automaton Automaton::createReverseDeterministic(const Automaton& other, std::pmr::memory_resource* resource){
+		const Storage& st = *other.shared;
+		fa::Automaton moulinex(resource);
+		moulinex.mut().alphabet = st.alphabet;
+		std::size_t n = st.ids.size();
+		std::pmr::monotonic_buffer_resource arena;
+
+		// predecessors of each dense state with their symbol, stored contiguously and sorted by symbol
+		std::pmr::vector<int> start(n + 1,0,&arena);
+		for(const auto& out : st.edges){
+			for(const auto& e : out){
+				if(e.symbol != fa::Epsilon){
+					for(int t : e.targets){
+						start[t + 1]++;
+					}
+				}
+			}
+		}
+		for(std::size_t d = 0; d < n; ++d){
+			start[d + 1] += start[d];
+		}
+		std::pmr::vector<std::pair<char,int>> preds(start.back(),&arena);
+		std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+		for(std::size_t d = 0; d < n; ++d){
+			for(const auto& e : st.edges[d]){
+				if(e.symbol != fa::Epsilon){
+					for(int t : e.targets){
+						preds[fill[t]++] = std::make_pair(e.symbol,(int)d);
+					}
+				}
+			}
+		}
+		for(std::size_t d = 0; d < n; ++d){
+			std::sort(preds.begin() + start[d],preds.begin() + start[d + 1]);
+		}
+
+		// subsets of dense states, numbered in breadth-first order
+		std::pmr::map<std::pmr::vector<int>,int> bd(&arena);
+		std::pmr::vector<const std::pmr::vector<int>*> subsets(&arena);
+
+		auto lookup = [&](std::pmr::vector<int>& stock){
+			std::sort(stock.begin(),stock.end());
+			auto res = bd.emplace(stock,(int)subsets.size());
+			if(res.second){
+				subsets.push_back(&res.first->first);
+				int compt = moulinex.appendState(res.first->second);
+				for(int s : stock){
+					if(st.flags[s] & StateInitial){
+						moulinex.setStateFinal(compt);
+						break;
+					}
+				}
+			}
+			return res.first->second;
+		};
+
+		std::pmr::vector<int> stock(&arena);
+		for(std::size_t d = 0; d < n; ++d){
+			if(st.flags[d] & StateFinal){
+				stock.push_back((int)d);
+			}
+		}
+		bool emptyStart = stock.empty();
+		moulinex.setStateInitial(lookup(stock));
+
+		std::pmr::vector<bool> mark(n,false,&arena);
+		for(std::size_t i = 0; i < subsets.size(); ++i){
+			for(auto a : st.alphabet){
+				stock.clear();
+				for(int t : *subsets[i]){
+					auto it = std::lower_bound(preds.begin() + start[t],preds.begin() + start[t + 1],std::make_pair(a,-1));
+					for(; it != preds.begin() + start[t + 1] && it->first == a; ++it){
+						if(!mark[it->second]){
+							mark[it->second] = true;
+							stock.push_back(it->second);
+						}
+					}
+				}
+				for(int s : stock){
+					mark[s] = false;
+				}
+				if(stock.empty() && !emptyStart){
+					continue;
+				}
+				int to = lookup(stock);
+				moulinex.appendTransition((int)i,a,to);
+			}
+		}
+
+		return moulinex;
+	}
+
+	Automaton Automaton::createMinimalBrzozowski(const Automaton& other){
+		// only the first determinized mirror is built, in the arena
+		std::pmr::monotonic_buffer_resource arena;
+		fa::Automaton thermomix = createReverseDeterministic(other,&arena);
+		fa::Automaton res = createReverseDeterministic(thermomix,other.getMemoryResource());
+		res.complete();
+		return res;
+	}
+
+	Automaton Automaton::createMinimalBrzozowski(Automaton&& other){
+		std::pmr::memory_resource* resource = other.getMemoryResource();
+		std::pmr::monotonic_buffer_resource arena;
+		fa::Automaton thermomix = createReverseDeterministic(other,&arena);
+		// the original is not needed anymore
+		other = Automaton();
+		fa::Automaton res = createReverseDeterministic(thermomix,resource);
+		res.complete();
+		return res;
+	}
+
+
+
+  Automaton Automaton::createMinimalHopcroft(const Automaton& other){
+	std::pmr::monotonic_buffer_resource arena;
+	fa::Automaton copy(other,&arena);
+	copy.removeNonAccessibleStates();
+	copy.determinize();
+	copy.complete();
+	const Storage& st = *copy.shared;
+
+	std::size_t n = st.ids.size();
+	std::pmr::vector<char> symbols(st.alphabet.begin(),st.alphabet.end(),&arena);
+	std::size_t k = symbols.size();
+
+	// transition table, and predecessors by symbol stored contiguously:
+	// those of t for the a-th symbol are in [start[a * n + t], start[a * n + t + 1])
+	std::pmr::vector<int> delta(n * k,&arena);
+	std::pmr::vector<int> start(n * k + 1,0,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(std::size_t a = 0; a < k; ++a){
+			delta[d * k + a] = copy.findTargets((int)d,symbols[a])->front();
+			start[a * n + delta[d * k + a] + 1]++;
+		}
+	}
+	for(std::size_t i = 0; i < n * k; ++i){
+		start[i + 1] += start[i];
+	}
+	std::pmr::vector<int> preds(n * k,&arena);
+	std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(std::size_t a = 0; a < k; ++a){
+			preds[fill[a * n + delta[d * k + a]]++] = (int)d;
+		}
+	}
+
+	// the smaller part of each split becomes a splitter
+	Partition blocks(n,&arena);
+	std::pmr::vector<int> work(&arena);
+	auto onSplit = [&](int, int block){ work.push_back(block); };
+	for(std::size_t d = 0; d < n; ++d){
+		if(st.flags[d] & StateFinal){
+			blocks.mark((int)d);
+		}
+	}
+	blocks.split(onSplit);
+
+	std::pmr::vector<int> splitter(&arena);
+	while(!work.empty()){
+		int c = work.back();
+		work.pop_back();
+		splitter.assign(blocks.begin(c),blocks.end(c));
+		for(std::size_t a = 0; a < k; ++a){
+			for(int t : splitter){
+				for(int i = start[a * n + t]; i < start[a * n + t + 1]; ++i){
+					blocks.mark(preds[i]);
+				}
+			}
+			blocks.split(onSplit);
+		}
+	}
+
+	// number the blocks in breadth-first order from the initial one
+	fa::Automaton R2D2(other.getMemoryResource());
+	R2D2.mut().alphabet = st.alphabet;
+	std::pmr::vector<int> number(blocks.size(),-1,&arena);
+	std::pmr::vector<int> order(&arena);
+	auto lookup = [&](int block){
+		if(number[block] < 0){
+			number[block] = (int)order.size();
+			order.push_back(block);
+			R2D2.appendState(number[block]);
+		}
+		return number[block];
+	};
+	R2D2.setStateInitial(lookup(blocks.blockOf(copy.getStateIndex(st.initialStates.front()))));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		int d = blocks.front(order[i]);
+		if(st.flags[d] & StateFinal){
+			R2D2.setStateFinal((int)i);
+		}
+		for(std::size_t a = 0; a < k; ++a){
+			int to = lookup(blocks.blockOf(delta[d * k + a]));
+			R2D2.appendTransition((int)i,symbols[a],to);
+		}
+	}
+
+	return R2D2;
+  }
+
+  Automaton Automaton::createMinimalValmari(const Automaton& other){
+	std::pmr::monotonic_buffer_resource arena;
+	fa::Automaton R2D2(other.getMemoryResource());
+	R2D2.mut().alphabet = other.shared->alphabet;
+	if(other.isLanguageEmpty()){
+		R2D2.addState(0);
+		R2D2.setStateInitial(0);
+		return R2D2;
+	}
+
+	fa::Automaton copy(other,&arena);
+	copy.removeNonAccessibleStates();
+	copy.determinize();
+	copy.removeNonCoAccessibleStates();
+	const Storage& st = *copy.shared;
+	std::size_t n = st.ids.size();
+
+	// the transitions, with the incoming ones of each state stored contiguously
+	std::pmr::vector<int> tails(&arena);
+	std::pmr::vector<char> labels(&arena);
+	std::pmr::vector<int> heads(&arena);
+	tails.reserve(st.nbTransitions);
+	labels.reserve(st.nbTransitions);
+	heads.reserve(st.nbTransitions);
+	std::pmr::vector<int> start(n + 1,0,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(const auto& e : st.edges[d]){
+			if(e.symbol != fa::Epsilon){
+				tails.push_back((int)d);
+				labels.push_back(e.symbol);
+				heads.push_back(e.targets.front());
+				start[e.targets.front() + 1]++;
+			}
+		}
+	}
+	std::size_t m = tails.size();
+	for(std::size_t d = 0; d < n; ++d){
+		start[d + 1] += start[d];
+	}
+	std::pmr::vector<int> incoming(m,&arena);
+	std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+	for(std::size_t t = 0; t < m; ++t){
+		incoming[fill[heads[t]]++] = (int)t;
+	}
+
+	// blocks of states split by finality, cords of transitions split by label
+	auto ignore = [](int, int){};
+	Partition blocks(n,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		if(st.flags[d] & StateFinal){
+			blocks.mark((int)d);
+		}
+	}
+	blocks.split(ignore);
+	Partition cords(m,&arena);
+	std::pmr::vector<int> byLabel(m,&arena);
+	for(std::size_t t = 0; t < m; ++t){
+		byLabel[t] = (int)t;
+	}
+	std::sort(byLabel.begin(),byLabel.end(),[&](int lhs, int rhs){ return labels[lhs] < labels[rhs]; });
+	for(std::size_t i = 0; i < m;){
+		std::size_t j = i;
+		for(; j < m && labels[byLabel[j]] == labels[byLabel[i]]; ++j){
+			cords.mark(byLabel[j]);
+		}
+		cords.split(ignore);
+		i = j;
+	}
+
+	// split the blocks by the tails of each cord, and the cords by the heads in each new block
+	std::size_t b = 1;
+	for(std::size_t c = 0; c < cords.size(); ++c){
+		for(const int* t = cords.begin((int)c); t != cords.end((int)c); ++t){
+			blocks.mark(tails[*t]);
+		}
+		blocks.split(ignore);
+		for(; b < blocks.size(); ++b){
+			for(const int* s = blocks.begin((int)b); s != blocks.end((int)b); ++s){
+				for(int i = start[*s]; i < start[*s + 1]; ++i){
+					cords.mark(incoming[i]);
+				}
+			}
+			cords.split(ignore);
+		}
+	}
+
+	// number the blocks in breadth-first order from the initial one
+	std::pmr::vector<int> number(blocks.size(),-1,&arena);
+	std::pmr::vector<int> order(&arena);
+	auto lookup = [&](int block){
+		if(number[block] < 0){
+			number[block] = (int)order.size();
+			order.push_back(block);
+			R2D2.appendState(number[block]);
+		}
+		return number[block];
+	};
+	R2D2.setStateInitial(lookup(blocks.blockOf(copy.getStateIndex(st.initialStates.front()))));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		int d = blocks.front(order[i]);
+		if(st.flags[d] & StateFinal){
+			R2D2.setStateFinal((int)i);
+		}
+		for(const auto& e : st.edges[d]){
+			if(e.symbol != fa::Epsilon){
+				int to = lookup(blocks.blockOf(e.targets.front()));
+				R2D2.appendTransition((int)i,e.symbol,to);
+			}
+		}
+	}
+
+	return R2D2;
+  }
+
+  Automaton Automaton::createMinimalParallel(const Automaton& other, unsigned threads){
+	threads = resolveThreads(threads);
+	std::pmr::monotonic_buffer_resource arena;
+	fa::Automaton copy(other,&arena);
+	copy.removeNonAccessibleStates();
+	if(!copy.isDeterministic()){
+		copy = createDeterministicParallel(copy,threads);
+	}
+	copy.complete();
+	const Storage& st = *copy.shared;
+
+	std::size_t n = st.ids.size();
+	std::pmr::vector<char> symbols(st.alphabet.begin(),st.alphabet.end(),&arena);
+	std::size_t k = symbols.size();
+	std::pmr::vector<int> delta(n * k,&arena);
+	parallelFor(threads,n,[&](unsigned, std::size_t begin, std::size_t end){
+		for(std::size_t d = begin; d < end; ++d){
+			// by symbol, the out-edges may also have an epsilon key
+			for(std::size_t a = 0; a < k; ++a){
+				delta[d * k + a] = copy.findTargets((int)d,symbols[a])->front();
+			}
+		}
+	});
+
+	// the classes of the round and of the next one, initially by finality
+	std::pmr::vector<int> classes(n,&arena);
+	std::pmr::vector<int> next(n,&arena);
+	int nbClasses = 0;
+	{
+		int final = -1;
+		int notFinal = -1;
+		for(std::size_t d = 0; d < n; ++d){
+			int& c = (st.flags[d] & StateFinal) ? final : notFinal;
+			if(c < 0){
+				c = nbClasses++;
+			}
+			classes[d] = c;
+		}
+	}
+
+	// open addressing table of representatives of the signatures
+	std::size_t capacity = 1;
+	while(capacity < 2 * n){
+		capacity *= 2;
+	}
+	std::size_t mask = capacity - 1;
+	std::pmr::vector<std::atomic<int>> table(capacity,&arena);
+	std::pmr::vector<int> representative(n,&arena);
+	std::pmr::vector<std::size_t> chunkCount(threads + 1,0,&arena);
+	auto hash = [&](std::size_t d){
+		std::size_t h = classes[d] * 0x9E3779B97F4A7C15ull;
+		for(std::size_t a = 0; a < k; ++a){
+			h = (h ^ (std::size_t)classes[delta[d * k + a]]) * 0xFF51AFD7ED558CCDull;
+			h ^= h >> 29;
+		}
+		return h;
+	};
+	auto sameSignature = [&](std::size_t lhs, std::size_t rhs){
+		if(classes[lhs] != classes[rhs]){
+			return false;
+		}
+		for(std::size_t a = 0; a < k; ++a){
+			if(classes[delta[lhs * k + a]] != classes[delta[rhs * k + a]]){
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for(;;){
+		parallelFor(threads,capacity,[&](unsigned, std::size_t begin, std::size_t end){
+			for(std::size_t i = begin; i < end; ++i){
+				table[i].store(-1,std::memory_order_relaxed);
+			}
+		});
+		// the first state to claim a slot represents the signature
+		parallelFor(threads,n,[&](unsigned chunk, std::size_t begin, std::size_t end){
+			std::size_t count = 0;
+			for(std::size_t d = begin; d < end; ++d){
+				for(std::size_t i = hash(d) & mask;; i = (i + 1) & mask){
+					int owner = -1;
+					if(table[i].compare_exchange_strong(owner,(int)d,std::memory_order_acq_rel)){
+						representative[d] = (int)d;
+						++count;
+						break;
+					}
+					if(sameSignature(owner,d)){
+						representative[d] = owner;
+						break;
+					}
+				}
+			}
+			chunkCount[chunk + 1] = count;
+		});
+		for(unsigned c = 0; c < threads; ++c){
+			chunkCount[c + 1] += chunkCount[c];
+		}
+		int nbNext = (int)chunkCount[threads];
+
+		// dense numbering of the representatives, then of the others
+		parallelFor(threads,n,[&](unsigned chunk, std::size_t begin, std::size_t end){
+			int number = (int)chunkCount[chunk];
+			for(std::size_t d = begin; d < end; ++d){
+				if(representative[d] == (int)d){
+					next[d] = number++;
+				}
+			}
+		});
+		parallelFor(threads,n,[&](unsigned, std::size_t begin, std::size_t end){
+			for(std::size_t d = begin; d < end; ++d){
+				if(representative[d] != (int)d){
+					next[d] = next[representative[d]];
+				}
+			}
+		});
+		std::fill(chunkCount.begin(),chunkCount.end(),0);
+
+		classes.swap(next);
+		if(nbNext == nbClasses){
+			break;
+		}
+		nbClasses = nbNext;
+	}
+
+	// number the classes in breadth-first order from the initial one
+	fa::Automaton R2D2(other.getMemoryResource());
+	R2D2.mut().alphabet = st.alphabet;
+	std::pmr::vector<int> number(nbClasses,-1,&arena);
+	std::pmr::vector<int> member(nbClasses,-1,&arena);
+	for(std::size_t d = n; d-- > 0;){
+		member[classes[d]] = (int)d;
+	}
+	std::pmr::vector<int> order(&arena);
+	auto lookup = [&](int c){
+		if(number[c] < 0){
+			number[c] = (int)order.size();
+			order.push_back(c);
+			R2D2.appendState(number[c]);
+		}
+		return number[c];
+	};
+	R2D2.setStateInitial(lookup(classes[copy.getStateIndex(st.initialStates.front())]));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		int d = member[order[i]];
+		if(st.flags[d] & StateFinal){
+			R2D2.setStateFinal((int)i);
+		}
+		for(std::size_t a = 0; a < k; ++a){
+			int to = lookup(classes[delta[d * k + a]]);
+			R2D2.appendTransition((int)i,symbols[a],to);
+		}
+	}
+
+	return R2D2;
+  }
+
+  MinimizeAlgorithm Automaton::chooseMinimizeAlgorithm(unsigned threads) const{
+	const Storage& st = *shared;
+	if(isDeterministic()){
+		std::size_t slots = st.ids.size() * st.alphabet.size();
+		if(slots <= SmallMinimizeSize){
+			return MinimizeAlgorithm::Moore;
+		}
+		return (threads > 1 && st.ids.size() >= ParallelMinimizeSize) ? MinimizeAlgorithm::Parallel : MinimizeAlgorithm::Hopcroft;
+	}
+
+	// the blowup of a determinization is estimated by the number of keys with
+	// several targets, forward for Hopcroft and backward for Brzozowski
+	std::pmr::monotonic_buffer_resource arena;
+	std::pmr::vector<std::pair<int,char>> backward(&arena);
+	backward.reserve(st.nbTransitions);
+	for(std::size_t d = 0; d < st.edges.size(); ++d){
+		for(const auto& e : st.edges[d]){
+			for(int t : e.targets){
+				backward.emplace_back(t,e.symbol);
+			}
+		}
+	}
+	std::sort(backward.begin(),backward.end());
+	std::size_t backwardKeys = st.finalStates.size() > 1;
+	for(std::size_t i = 1; i < backward.size(); ++i){
+		backwardKeys += (backward[i] == backward[i - 1] && (i + 1 == backward.size() || backward[i + 1] != backward[i]));
+	}
+	std::size_t forwardKeys = st.nbNonDeterministicKeys + (st.initialStates.size() > 1);
+
+	return (backwardKeys < forwardKeys) ? MinimizeAlgorithm::Brzozowski : MinimizeAlgorithm::Hopcroft;
+  }
+
+  Automaton Automaton::createMinimal(const Automaton& other, MinimizeOptions options){
+	auto begin = std::chrono::steady_clock::now();
+	MinimizeAlgorithm algorithm = options.algorithm;
+	if(algorithm == MinimizeAlgorithm::Auto){
+		algorithm = other.chooseMinimizeAlgorithm(resolveThreads(options.threads));
+	}
+
+	fa::Automaton res;
+	switch(algorithm){
+		case MinimizeAlgorithm::Moore:
+			res = createMinimalMoore(other);
+			break;
+		case MinimizeAlgorithm::Brzozowski:
+			res = createMinimalBrzozowski(other);
+			break;
+		case MinimizeAlgorithm::Valmari:
+			res = createMinimalValmari(other);
+			break;
+		case MinimizeAlgorithm::Parallel:
+			res = createMinimalParallel(other,options.threads);
+			break;
+		default:
+			algorithm = MinimizeAlgorithm::Hopcroft;
+			res = createMinimalHopcroft(other);
+			break;
+	}
+
+	if(options.stats != nullptr){
+		options.stats->algorithm = algorithm;
+		options.stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+	return res;
+  }
+
+  void Automaton::reduceBySimulation(){
+	const Storage& st = *shared;
+	std::size_t n = st.ids.size();
+	std::pmr::monotonic_buffer_resource arena;
+
+	// the keys (state, symbol) are the out-edges, numbered contiguously
+	std::pmr::vector<int> keyStart(n + 1,0,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		keyStart[d + 1] = keyStart[d] + (int)st.edges[d].size();
+	}
+	std::size_t nbKeys = keyStart[n];
+
+	// predecessors of each state with the symbol and the key, sorted by symbol
+	struct Pred {
+		char symbol;
+		int state;
+		int key;
+		bool operator<(const Pred& other) const { return symbol < other.symbol; }
+	};
+	std::pmr::vector<int> start(n + 1,0,&arena);
+	for(const auto& out : st.edges){
+		for(const auto& e : out){
+			for(int t : e.targets){
+				start[t + 1]++;
+			}
+		}
+	}
+	for(std::size_t d = 0; d < n; ++d){
+		start[d + 1] += start[d];
+	}
+	std::pmr::vector<Pred> preds(start.back(),&arena);
+	std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(std::size_t j = 0; j < st.edges[d].size(); ++j){
+			const auto& e = st.edges[d][j];
+			for(int t : e.targets){
+				preds[fill[t]++] = Pred{e.symbol,(int)d,keyStart[d] + (int)j};
+			}
+		}
+	}
+	for(std::size_t d = 0; d < n; ++d){
+		std::sort(preds.begin() + start[d],preds.begin() + start[d + 1]);
+	}
+
+	// sim[p * n + q] tells that q simulates p, first from the finality and the symbols
+	std::pmr::vector<bool> sim(n * n,false,&arena);
+	for(std::size_t p = 0; p < n; ++p){
+		for(std::size_t q = 0; q < n; ++q){
+			if((st.flags[p] & StateFinal) && !(st.flags[q] & StateFinal)){
+				continue;
+			}
+			const auto& outP = st.edges[p];
+			const auto& outQ = st.edges[q];
+			auto itQ = outQ.begin();
+			bool included = true;
+			for(const auto& e : outP){
+				while(itQ != outQ.end() && itQ->symbol < e.symbol){
+					++itQ;
+				}
+				if(itQ == outQ.end() || itQ->symbol != e.symbol){
+					included = false;
+					break;
+				}
+			}
+			sim[p * n + q] = included;
+		}
+	}
+
+	// counters of Henzinger, Henzinger and Kopke: for the key (q, a) and the state p,
+	// the number of a-successors of q that simulate p
+	std::pmr::vector<int> count(nbKeys * n,0,&arena);
+	for(std::size_t q = 0; q < n; ++q){
+		for(std::size_t j = 0; j < st.edges[q].size(); ++j){
+			int* row = count.data() + (keyStart[q] + j) * n;
+			for(int t : st.edges[q][j].targets){
+				for(std::size_t p = 0; p < n; ++p){
+					row[p] += sim[p * n + t];
+				}
+			}
+		}
+	}
+
+	std::pmr::vector<std::pair<int,int>> work(&arena);
+	// q cannot simulate the a-predecessors of p anymore
+	auto refute = [&](int p, char a, int q){
+		auto first = std::lower_bound(preds.begin() + start[p],preds.begin() + start[p + 1],Pred{a,0,0});
+		for(auto it = first; it != preds.begin() + start[p + 1] && it->symbol == a; ++it){
+			if(sim[it->state * n + q]){
+				sim[it->state * n + q] = false;
+				work.emplace_back(it->state,q);
+			}
+		}
+	};
+	for(std::size_t q = 0; q < n; ++q){
+		for(std::size_t j = 0; j < st.edges[q].size(); ++j){
+			const int* row = count.data() + (keyStart[q] + j) * n;
+			for(std::size_t p = 0; p < n; ++p){
+				if(row[p] == 0){
+					refute((int)p,st.edges[q][j].symbol,(int)q);
+				}
+			}
+		}
+	}
+	while(!work.empty()){
+		std::pair<int,int> removed = work.back();
+		work.pop_back();
+		for(int i = start[removed.second]; i < start[removed.second + 1]; ++i){
+			const Pred& pr = preds[i];
+			if(--count[(std::size_t)pr.key * n + removed.first] == 0){
+				refute(removed.first,pr.symbol,pr.state);
+			}
+		}
+	}
+
+	// classes of mutually simulating states, numbered by their first state
+	std::pmr::vector<int> classes(n,-1,&arena);
+	std::pmr::vector<int> reps(&arena);
+	for(std::size_t p = 0; p < n; ++p){
+		if(classes[p] >= 0){
+			continue;
+		}
+		classes[p] = (int)reps.size();
+		for(std::size_t q = p + 1; q < n; ++q){
+			if(classes[q] < 0 && sim[p * n + q] && sim[q * n + p]){
+				classes[q] = (int)reps.size();
+			}
+		}
+		reps.push_back((int)p);
+	}
+	auto dominated = [&](int c, const std::pmr::vector<int>& siblings){
+		for(int other : siblings){
+			if(other != c && sim[reps[c] * n + reps[other]]){
+				return true;
+			}
+		}
+		return false;
+	};
+
+	fa::Automaton quotient(getMemoryResource());
+	quotient.mut().alphabet = st.alphabet;
+	std::pmr::vector<int> initials(&arena);
+	for(std::size_t c = 0; c < reps.size(); ++c){
+		quotient.appendState(st.ids[reps[c]]);
+	}
+	for(std::size_t p = 0; p < n; ++p){
+		if((st.flags[p] & StateInitial) && std::find(initials.begin(),initials.end(),classes[p]) == initials.end()){
+			initials.push_back(classes[p]);
+		}
+	}
+	for(int c : initials){
+		if(!dominated(c,initials)){
+			quotient.setStateInitial(st.ids[reps[c]]);
+		}
+	}
+
+	// the transitions of a class are the union of those of its states, without the little brothers
+	std::pmr::vector<int> members(n,&arena);
+	std::pmr::vector<int> memberStart(reps.size() + 1,0,&arena);
+	for(std::size_t p = 0; p < n; ++p){
+		memberStart[classes[p] + 1]++;
+	}
+	for(std::size_t c = 0; c < reps.size(); ++c){
+		memberStart[c + 1] += memberStart[c];
+	}
+	std::pmr::vector<int> next(memberStart.begin(),memberStart.end() - 1,&arena);
+	for(std::size_t p = 0; p < n; ++p){
+		members[next[classes[p]]++] = (int)p;
+	}
+	std::pmr::vector<std::pair<char,int>> targets(&arena);
+	std::pmr::vector<int> siblings(&arena);
+	for(std::size_t c = 0; c < reps.size(); ++c){
+		if(st.flags[reps[c]] & StateFinal){
+			quotient.setStateFinal(st.ids[reps[c]]);
+		}
+		targets.clear();
+		for(int i = memberStart[c]; i < memberStart[c + 1]; ++i){
+			for(const auto& e : st.edges[members[i]]){
+				for(int t : e.targets){
+					targets.emplace_back(e.symbol,classes[t]);
+				}
+			}
+		}
+		std::sort(targets.begin(),targets.end());
+		targets.erase(std::unique(targets.begin(),targets.end()),targets.end());
+		for(std::size_t i = 0; i < targets.size();){
+			siblings.clear();
+			std::size_t j = i;
+			for(; j < targets.size() && targets[j].first == targets[i].first; ++j){
+				siblings.push_back(targets[j].second);
+			}
+			for(int to : siblings){
+				if(!dominated(to,siblings)){
+					quotient.appendTransition((int)c,targets[i].first,to);
+				}
+			}
+			i = j;
+		}
+	}
+
+	*this = std::move(quotient);
+  }
+
+  Automaton Automaton::createReducedBySimulation(const Automaton& other){
+	fa::Automaton glados = other;
+	glados.removeNonAccessibleStates();
+	glados.removeNonCoAccessibleStates();
+	// the pruning may leave states that are not accessible anymore
+	glados.reduceBySimulation();
+	glados.removeNonAccessibleStates();
+
+	// the backward simulation is the forward one of the mirror
+	glados.mirror();
+	glados.reduceBySimulation();
+	glados.removeNonAccessibleStates();
+	glados.mirror();
+	return glados;
+  }
+
+  Automaton Automaton::createBisimulationQuotient(const Automaton& other){
+	return createBisimulationQuotient(other,other.getMemoryResource());
+  }
+
+  Automaton Automaton::createBisimulationQuotient(const Automaton& other, std::pmr::memory_resource* resource){
+	const Storage& st = *other.shared;
+	std::size_t n = st.ids.size();
+	std::pmr::monotonic_buffer_resource arena;
+
+	// the transitions, with the incoming ones of each state stored contiguously,
+	// each one points to the count record of its key: initially the out-edge
+	std::pmr::vector<int> tails(&arena);
+	std::pmr::vector<char> labels(&arena);
+	std::pmr::vector<int> records(&arena);
+	std::pmr::vector<int> counts(&arena);
+	std::pmr::vector<int> start(n + 1,0,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(const auto& e : st.edges[d]){
+			for(int t : e.targets){
+				tails.push_back((int)d);
+				labels.push_back(e.symbol);
+				records.push_back((int)counts.size());
+				start[t + 1]++;
+			}
+			counts.push_back((int)e.targets.size());
+		}
+	}
+	std::size_t m = tails.size();
+	for(std::size_t d = 0; d < n; ++d){
+		start[d + 1] += start[d];
+	}
+	std::pmr::vector<int> incoming(m,&arena);
+	std::pmr::vector<int> fill(start.begin(),start.end() - 1,&arena);
+	{
+		std::size_t t = 0;
+		for(std::size_t d = 0; d < n; ++d){
+			for(const auto& e : st.edges[d]){
+				for(int h : e.targets){
+					incoming[fill[h]++] = (int)t++;
+				}
+			}
+		}
+	}
+
+	// the blocks are grouped in compound blocks, those with several blocks are splitters to use
+	Partition blocks(n,&arena);
+	std::pmr::vector<int> compoundOf(&arena);
+	std::pmr::vector<int> position(&arena);
+	std::pmr::vector<std::pmr::vector<int>> compounds(&arena);
+	std::pmr::vector<bool> pending(&arena);
+	std::pmr::vector<int> work(&arena);
+	auto schedule = [&](int c){
+		if(compounds[c].size() > 1 && !pending[c]){
+			pending[c] = true;
+			work.push_back(c);
+		}
+	};
+	auto onSplit = [&](int block, int newBlock){
+		int c = compoundOf[block];
+		compoundOf.push_back(c);
+		position.push_back((int)compounds[c].size());
+		compounds[c].push_back(newBlock);
+		schedule(c);
+	};
+	if(n){
+		compoundOf.push_back(0);
+		position.push_back(0);
+		compounds.emplace_back(1,0);
+		pending.push_back(false);
+	}
+
+	// the blocks are first split by finality and by the symbols of the out-edges
+	for(std::size_t d = 0; d < n; ++d){
+		if(st.flags[d] & StateFinal){
+			blocks.mark((int)d);
+		}
+	}
+	blocks.split(onSplit);
+	std::pmr::vector<std::pair<char,int>> keys(&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		for(const auto& e : st.edges[d]){
+			keys.emplace_back(e.symbol,(int)d);
+		}
+	}
+	std::sort(keys.begin(),keys.end());
+	for(std::size_t i = 0; i < keys.size();){
+		std::size_t j = i;
+		for(; j < keys.size() && keys[j].first == keys[i].first; ++j){
+			blocks.mark(keys[j].second);
+		}
+		blocks.split(onSplit);
+		i = j;
+	}
+
+	std::pmr::vector<int> splitter(&arena);
+	std::pmr::vector<int> into(&arena);
+	std::pmr::vector<int> grouped(&arena);
+	std::pmr::vector<int> bucket(256,0,&arena);
+	std::pmr::vector<unsigned char> used(&arena);
+	std::pmr::vector<int> recordOf(n,-1,&arena);
+	std::pmr::vector<int> previousOf(n,-1,&arena);
+	std::pmr::vector<int> touched(&arena);
+	while(!work.empty()){
+		int c = work.back();
+		work.pop_back();
+		pending[c] = false;
+		if(compounds[c].size() < 2){
+			continue;
+		}
+
+		// the smaller of two blocks of the compound becomes a compound of its own
+		int b = compounds[c][0];
+		if(blocks.size(compounds[c][1]) < blocks.size(b)){
+			b = compounds[c][1];
+		}
+		int last = compounds[c].back();
+		compounds[c][position[b]] = last;
+		position[last] = position[b];
+		compounds[c].pop_back();
+		compoundOf[b] = (int)compounds.size();
+		position[b] = 0;
+		compounds.emplace_back(1,b);
+		pending.push_back(false);
+		schedule(c);
+
+		// the transitions into the splitter, by symbol
+		splitter.assign(blocks.begin(b),blocks.end(b));
+		into.clear();
+		for(int y : splitter){
+			into.insert(into.end(),incoming.begin() + start[y],incoming.begin() + start[y + 1]);
+		}
+		// grouped by a counting sort over the symbols present only, so in O(|into|)
+		for(int t : into){
+			unsigned char symbol = labels[t];
+			if(bucket[symbol]++ == 0){
+				used.push_back(symbol);
+			}
+		}
+		int offset = 0;
+		for(unsigned char symbol : used){
+			int count = bucket[symbol];
+			bucket[symbol] = offset;
+			offset += count;
+		}
+		grouped.resize(into.size());
+		for(int t : into){
+			grouped[bucket[(unsigned char)labels[t]]++] = t;
+		}
+		for(unsigned char symbol : used){
+			bucket[symbol] = 0;
+		}
+		used.clear();
+		into.swap(grouped);
+
+		for(std::size_t i = 0; i < into.size();){
+			std::size_t j = i;
+			for(; j < into.size() && labels[into[j]] == labels[into[i]]; ++j){
+				int x = tails[into[j]];
+				if(recordOf[x] < 0){
+					recordOf[x] = (int)counts.size();
+					previousOf[x] = records[into[j]];
+					counts.push_back(0);
+					touched.push_back(x);
+				}
+				counts[recordOf[x]]++;
+			}
+
+			// split by the predecessors, then by those without successor in the rest of the compound
+			for(int x : touched){
+				blocks.mark(x);
+			}
+			blocks.split(onSplit);
+			for(int x : touched){
+				if(counts[recordOf[x]] == counts[previousOf[x]]){
+					blocks.mark(x);
+				}
+			}
+			blocks.split(onSplit);
+
+			for(std::size_t k = i; k < j; ++k){
+				counts[records[into[k]]]--;
+				records[into[k]] = recordOf[tails[into[k]]];
+			}
+			for(int x : touched){
+				recordOf[x] = -1;
+			}
+			touched.clear();
+			i = j;
+		}
+	}
+
+	// one state by block, numbered by its first state
+	fa::Automaton quotient(resource);
+	quotient.mut().alphabet = st.alphabet;
+	std::pmr::vector<int> number(blocks.size(),-1,&arena);
+	std::pmr::vector<int> classes(n,&arena);
+	for(std::size_t d = 0; d < n; ++d){
+		int block = blocks.blockOf((int)d);
+		if(number[block] < 0){
+			number[block] = quotient.appendState(st.ids[d]);
+			if(st.flags[d] & StateFinal){
+				quotient.setStateFinal(st.ids[d]);
+			}
+		}
+		classes[d] = number[block];
+		if(st.flags[d] & StateInitial){
+			quotient.setStateInitial(quotient.shared->ids[classes[d]]);
+		}
+	}
+	for(std::size_t d = 0; d < n; ++d){
+		for(const auto& e : st.edges[d]){
+			for(int t : e.targets){
+				quotient.insertTransition(classes[d],e.symbol,classes[t]);
+			}
+		}
+	}
+
+	return quotient;
+  }
+
+  Scanner::Scanner(const std::vector<Automaton>& automata)
+  : nbStates(1), classOf(256,0)
+  {
+	std::size_t nbClasses = 1;
+	for(const auto& fa : automata){
+		for(char a : fa.shared->alphabet){
+			if(!classOf[(unsigned char)a]){
+				classOf[(unsigned char)a] = (int)nbClasses++;
+			}
+		}
+	}
+
+	std::vector<Automaton> dfas;
+	dfas.reserve(automata.size());
+	for(const auto& fa : automata){
+		dfas.push_back(Automaton::createMinimalValmari(fa));
+		nbStates += dfas.back().countStates();
+	}
+
+	// the missing transitions go to the dead state
+	delta.assign(nbClasses * nbStates,0);
+	final.assign(nbStates,0);
+	std::size_t base = 1;
+	for(const auto& dfa : dfas){
+		const Automaton::Storage& st = *dfa.shared;
+		initial.push_back((int)base + dfa.getStateIndex(st.initialStates.front()));
+		for(std::size_t d = 0; d < st.ids.size(); ++d){
+			final[base + d] = (st.flags[d] & Automaton::StateFinal) != 0;
+			for(const auto& e : st.edges[d]){
+				if(e.symbol != fa::Epsilon){
+					delta[classOf[(unsigned char)e.symbol] * nbStates + base + d] = (int)base + e.targets.front();
+				}
+			}
+		}
+		base += st.ids.size();
+	}
+  }
+
+  std::size_t Scanner::countAutomata() const{
+	return initial.size();
+  }
+
+  std::vector<std::uint64_t> Scanner::match(const std::string& word) const{
+	char buffer[ReadBufferSize];
+	std::pmr::monotonic_buffer_resource arena(buffer,sizeof(buffer));
+	std::pmr::vector<int> current(initial.begin(),initial.end(),&arena);
+	std::size_t count = current.size();
+	int* state = current.data();
+
+	for(std::size_t i = 0; i < word.size(); ++i){
+		gather(state,delta.data() + classOf[(unsigned char)word[i]] * nbStates,count);
+		// from time to time, stop if all the automata are in the dead state
+		if(i % 64 == 63){
+			int alive = 0;
+			for(std::size_t j = 0; j < count; ++j){
+				alive |= state[j];
+			}
+			if(!alive){
+				break;
+			}
+		}
+	}
+
+	std::vector<std::uint64_t> accepted((count + 63) / 64,0);
+	for(std::size_t j = 0; j < count; ++j){
+		if(final[state[j]]){
+			accepted[j / 64] |= std::uint64_t(1) << (j % 64);
+		}
+	}
+	return accepted;
+  }
+
+  LazyRegex::LazyRegex(std::string_view regex)
+  : work(0), start(-1), nbClasses(0)
+  {
+	std::pmr::monotonic_buffer_resource arena;
+	RegexParser parser(regex,&arena);
+	int root = parser.parse();
+	if(root < 0){
+		return;
+	}
+
+	// the bytes are in the same class if they are in the same sets
+	std::map<std::vector<bool>,int> signatures;
+	classOf.resize(256);
+	for(int c = 0; c < 256; ++c){
+		std::vector<bool> signature(parser.countSets());
+		for(std::size_t set = 0; set < signature.size(); ++set){
+			signature[set] = parser.symbols((int)set)[c];
+		}
+		auto res = signatures.emplace(signature,(int)nbClasses);
+		if(res.second){
+			representative.push_back((char)c);
+			++nbClasses;
+		}
+		classOf[c] = res.first->second;
+		if(std::find(signature.begin(),signature.end(),true) != signature.end()){
+			alphabet.push_back((char)c);
+		}
+	}
+
+	nothing = make(Nothing,0,0);
+	empty = make(Empty,0,0);
+
+	// the terms of the syntax tree, a shared node is converted once
+	std::vector<int> converted(parser.countNodes(),-1);
+	auto convert = [&](auto& self, int n) -> int {
+		if(converted[n] >= 0){
+			return converted[n];
+		}
+		const RegexParser::Node& node = parser.node(n);
+		std::vector<int> children;
+		for(int c = node.head; c >= 0; c = parser.cell(c).next){
+			children.push_back(self(self,parser.cell(c).node));
+		}
+		int term = empty;
+		switch(node.kind){
+			case RegexParser::Empty:
+				break;
+			case RegexParser::Symbols:
+				sets.push_back(parser.symbols(node.set));
+				term = make(Symbols,(int)sets.size() - 1,0);
+				break;
+			case RegexParser::Star:
+				term = star(children.front());
+				break;
+			case RegexParser::Alt:
+				term = nothing;
+				for(int child : children){
+					term = alt(term,child);
+				}
+				break;
+			case RegexParser::Concat:
+				for(auto it = children.rbegin(); it != children.rend(); ++it){
+					term = concat(*it,term);
+				}
+				break;
+		}
+		return converted[n] = term;
+	};
+	stateOf(convert(convert,root));
+	start = 0;
+  }
+
+  bool LazyRegex::isValid() const{
+	return start >= 0 && work <= LazyMaxWork;
+  }
+
+  std::size_t LazyRegex::countStates() const{
+	return termOf.size();
+  }
+
+  bool LazyRegex::match(const std::string& word){
+	if(!isValid()){
+		return false;
+	}
+	int state = start;
+	for(char c : word){
+		state = step(state,classOf[(unsigned char)c]);
+		if(termOf[state] == nothing){
+			return false;
+		}
+	}
+	// a derivation cut by the budget is not trusted
+	return isValid() && terms[termOf[state]].nullable;
+  }
+
+  Automaton LazyRegex::toAutomaton(){
+	fa::Automaton R2D2;
+	if(!isValid()){
+		return R2D2;
+	}
+	std::vector<char> symbols = alphabet;
+	if(symbols.empty()){
+		symbols.push_back('a');
+	}
+	for(char a : symbols){
+		R2D2.addSymbol(a);
+	}
+
+	// every state reachable from the start, numbered in breadth-first order
+	std::vector<int> number(termOf.size(),-1);
+	std::vector<int> order;
+	auto lookup = [&](int state){
+		if(number.size() <= (std::size_t)state){
+			number.resize(state + 1,-1);
+		}
+		if(number[state] < 0){
+			number[state] = (int)order.size();
+			order.push_back(state);
+			R2D2.addState(number[state]);
+			if(terms[termOf[state]].nullable){
+				R2D2.setStateFinal(number[state]);
+			}
+		}
+		return number[state];
+	};
+	R2D2.setStateInitial(lookup(start));
+	for(std::size_t i = 0; i < order.size(); ++i){
+		for(char a : symbols){
+			int to = lookup(step(order[i],classOf[(unsigned char)a]));
+			R2D2.addTransition((int)i,a,to);
+		}
+		if(!isValid()){
+			return fa::Automaton();
+		}
+	}
+	return R2D2;
+  }
+
+  std::size_t LazyRegex::TermKeyHash::operator()(const TermKey& key) const{
+	std::uint64_t h = ((std::uint64_t)(std::uint32_t)key.lhs << 32) | (std::uint32_t)key.rhs;
+	h = (h ^ key.kind) * 0x9E3779B97F4A7C15ull;
+	return h ^ (h >> 32);
+  }
+
+  int LazyRegex::make(Kind kind, int lhs, int rhs){
+	auto it = index.find(TermKey{kind,lhs,rhs});
+	if(it != index.end()){
+		return it->second;
+	}
+	if(!spend(1)){
+		return nothing;
+	}
+	bool nullable = false;
+	switch(kind){
+		case Empty: case Star: nullable = true; break;
+		case Concat: nullable = terms[lhs].nullable && terms[rhs].nullable; break;
+		case Alt: nullable = terms[lhs].nullable || terms[rhs].nullable; break;
+		default: break;
+	}
+	index.emplace(TermKey{kind,lhs,rhs},(int)terms.size());
+	terms.push_back({kind,nullable,lhs,rhs});
+	return (int)terms.size() - 1;
+  }
+
+  int LazyRegex::concat(int lhs, int rhs){
+	if(lhs == nothing || rhs == nothing){
+		return nothing;
+	}
+	if(lhs == empty){
+		return rhs;
+	}
+	if(rhs == empty){
+		return lhs;
+	}
+	// kept right-nested: the factors of lhs are put in front of rhs from the last one
+	std::vector<int> factors;
+	for(; terms[lhs].kind == Concat && spend(1); lhs = terms[lhs].rhs){
+		factors.push_back(terms[lhs].lhs);
+	}
+	factors.push_back(lhs);
+	int res = rhs;
+	for(auto it = factors.rbegin(); it != factors.rend(); ++it){
+		res = make(Concat,*it,res);
+	}
+	return res;
+  }
+
+  int LazyRegex::alt(int lhs, int rhs){
+	if(lhs == nothing || lhs == rhs){
+		return rhs;
+	}
+	if(rhs == nothing){
+		return lhs;
+	}
+	// an operand greater than all those of the other chain goes in front of it
+	for(int i = 0; i < 2; ++i){
+		int head = terms[rhs].kind == Alt ? terms[rhs].lhs : rhs;
+		if(terms[lhs].kind != Alt && lhs > head){
+			return make(Alt,lhs,rhs);
+		}
+		std::swap(lhs,rhs);
+	}
+	return alt(std::vector<int>{lhs,rhs});
+  }
+
+  int LazyRegex::alt(const std::vector<int>& operands){
+	// the alternatives are flattened, unique by their marks and sorted in decreasing
+	// order, then right-nested; a chain already walked is a shared tail, not walked again
+	marks.resize(terms.size(),0);
+	std::vector<int> unique;
+	std::vector<int> walked;
+	auto add = [&](int term){
+		if(term != nothing && !marks[term]){
+			marks[term] = 1;
+			unique.push_back(term);
+		}
+	};
+	for(int term : operands){
+		for(; terms[term].kind == Alt && !marks[term] && spend(1); term = terms[term].rhs){
+			marks[term] = 1;
+			walked.push_back(term);
+			add(terms[term].lhs);
+		}
+		if(terms[term].kind != Alt){
+			add(term);
+		}
+	}
+	for(int term : unique){
+		marks[term] = 0;
+	}
+	for(int term : walked){
+		marks[term] = 0;
+	}
+	if(unique.empty() || !spend(0)){
+		return nothing;
+	}
+	std::sort(unique.begin(),unique.end(),std::greater<int>());
+	int res = unique.back();
+	for(std::size_t i = unique.size() - 1; i-- > 0;){
+		res = make(Alt,unique[i],res);
+	}
+	return res;
+  }
+
+  int LazyRegex::star(int term){
+	if(term == nothing || term == empty){
+		return empty;
+	}
+	if(terms[term].kind == Star){
+		return term;
+	}
+	return make(Star,term,0);
+  }
+
+  bool LazyRegex::spend(std::size_t n){
+	work += n;
+	return work <= LazyMaxWork;
+  }
+
+  int LazyRegex::derive(int term, int symbolClass){
+	auto keyOf = [symbolClass](int term){
+		return ((std::uint64_t)(std::uint32_t)term << 32) | (std::uint32_t)symbolClass;
+	};
+	auto it = derivatives.find(keyOf(term));
+	if(it != derivatives.end()){
+		return it->second;
+	}
+	if(!spend(1)){
+		return nothing;
+	}
+	Term t = terms[term];
+	int res = nothing;
+	switch(t.kind){
+		case Symbols:
+			res = sets[t.lhs][(unsigned char)representative[symbolClass]] ? empty : nothing;
+			break;
+		case Concat: {
+			// d(c r) is d(c) r, and also d(r) if c is nullable: the suffixes of the chain
+			// are stacked up to one whose derivative is not needed or known, then derived
+			// from the last one, so a factor is never a Concat and the recursion stays shallow
+			std::vector<int> suffixes{term};
+			for(int rest = t.rhs; terms[terms[suffixes.back()].lhs].nullable && terms[rest].kind == Concat
+			  && derivatives.find(keyOf(rest)) == derivatives.end() && spend(1); rest = terms[rest].rhs){
+				suffixes.push_back(rest);
+			}
+			while(!suffixes.empty()){
+				Term suffix = terms[suffixes.back()];
+				res = concat(derive(suffix.lhs,symbolClass),suffix.rhs);
+				if(terms[suffix.lhs].nullable){
+					res = alt(res,derive(suffix.rhs,symbolClass));
+				}
+				derivatives.emplace(keyOf(suffixes.back()),res);
+				suffixes.pop_back();
+			}
+			break;
+		}
+		case Alt: {
+			// the operands of the chain one by one, none is an Alt
+			std::vector<int> operands;
+			int rest = term;
+			for(; terms[rest].kind == Alt && spend(1); rest = terms[rest].rhs){
+				operands.push_back(derive(terms[rest].lhs,symbolClass));
+			}
+			operands.push_back(derive(rest,symbolClass));
+			res = alt(operands);
+			break;
+		}
+		case Star:
+			res = concat(derive(t.lhs,symbolClass),term);
+			break;
+		default:
+			break;
+	}
+	derivatives.emplace(keyOf(term),res);
+	return res;
+  }
+
+  int LazyRegex::stateOf(int term){
+	auto res = states.emplace(term,(int)termOf.size());
+	if(res.second){
+		termOf.push_back(term);
+		next.resize(next.size() + nbClasses,-1);
+	}
+	return res.first->second;
+  }
+
+  int LazyRegex::step(int state, int symbolClass){
+	std::size_t slot = (std::size_t)state * nbClasses + symbolClass;
+	if(next[slot] < 0){
+		int to = stateOf(derive(termOf[state],symbolClass));
+		next[slot] = to;
+	}
+	return next[slot];
+  }
+
+  BackwardMatcher::BackwardMatcher(const Automaton& automaton)
+  : valid(automaton.isValid()), empty(true), window(0), classOf(256,0), nbClasses(1)
+  , nbStates(0), chunks(0), nbForward(1), initial(0)
+  {
+	if(!valid){
+		return;
+	}
+	Automaton dfa = Automaton::createMinimalValmari(automaton);
+	const Automaton::Storage& st = *dfa.shared;
+	for(char a : st.alphabet){
+		classOf[(unsigned char)a] = (int)nbClasses++;
+	}
+
+	nbForward = 1 + st.ids.size();
+	delta.assign(nbClasses * nbForward,0);
+	final.assign(nbForward,0);
+	initial = 1 + dfa.getStateIndex(st.initialStates.front());
+	for(std::size_t d = 0; d < st.ids.size(); ++d){
+		final[1 + d] = (st.flags[d] & Automaton::StateFinal) != 0;
+		for(const auto& e : st.edges[d]){
+			if(e.symbol != fa::Epsilon){
+				delta[classOf[(unsigned char)e.symbol] * nbForward + 1 + d] = 1 + e.targets.front();
+			}
+		}
+	}
+
+	// the length of the shortest word, by a breadth-first search
+	std::vector<int> distance(nbForward,-1);
+	std::vector<int> queue(1,initial);
+	distance[initial] = 0;
+	for(std::size_t head = 0; head < queue.size() && empty; ++head){
+		int q = queue[head];
+		if(final[q]){
+			window = distance[q];
+			empty = false;
+		}
+		for(std::size_t c = 1; c < nbClasses; ++c){
+			int to = delta[c * nbForward + q];
+			if(to && distance[to] < 0){
+				distance[to] = distance[q] + 1;
+				queue.push_back(to);
+			}
+		}
+	}
+	if(empty){
+		return;
+	}
+
+	// the minimal automaton is trimmed, so from all the states its mirror reads the reversed factors
+	Automaton bigBrother = Automaton::createMirror(dfa);
+	const Automaton::Storage& ms = *bigBrother.shared;
+	nbStates = ms.ids.size();
+	prefixes.assign((nbStates + 63) / 64,0);
+	edgeStart.assign(nbClasses * nbStates + 1,0);
+	for(std::size_t d = 0; d < nbStates; ++d){
+		if(ms.flags[d] & Automaton::StateFinal){
+			prefixes[d / 64] |= std::uint64_t(1) << (d % 64);
+		}
+		for(const auto& e : ms.edges[d]){
+			if(e.symbol != fa::Epsilon){
+				edgeStart[classOf[(unsigned char)e.symbol] * nbStates + d + 1] += (int)e.targets.size();
+			}
+		}
+	}
+	for(std::size_t i = 1; i < edgeStart.size(); ++i){
+		edgeStart[i] += edgeStart[i - 1];
+	}
+	edgeTargets.resize(edgeStart.back());
+	std::vector<int> fill(edgeStart.begin(),edgeStart.end() - 1);
+	for(std::size_t d = 0; d < nbStates; ++d){
+		for(const auto& e : ms.edges[d]){
+			if(e.symbol != fa::Epsilon){
+				for(int t : e.targets){
+					edgeTargets[fill[classOf[(unsigned char)e.symbol] * nbStates + d]++] = t;
+				}
+			}
+		}
+	}
+	if(nbStates > 64){
+		return;
+	}
+
+	// successors of each byte of the set, built from the byte without its lowest bit
+	chunks = (nbStates + 7) / 8;
+	masks.assign(nbClasses * chunks * 256,0);
+	for(std::size_t c = 1; c < nbClasses; ++c){
+		for(std::size_t k = 0; k < chunks; ++k){
+			std::uint64_t* table = masks.data() + (c * chunks + k) * 256;
+			for(unsigned b = 1; b < 256; ++b){
+				std::size_t q = k * 8 + __builtin_ctz(b);
+				std::uint64_t successors = 0;
+				if(q < nbStates){
+					for(int e = edgeStart[c * nbStates + q]; e < edgeStart[c * nbStates + q + 1]; ++e){
+						successors |= std::uint64_t(1) << edgeTargets[e];
+					}
+				}
+				table[b] = table[b & (b - 1)] | successors;
+			}
+		}
+	}
+	edgeStart.clear();
+	edgeTargets.clear();
+  }
+
+  bool BackwardMatcher::isValid() const{
+	return valid;
+  }
+
+  std::size_t BackwardMatcher::getWindow() const{
+	return window;
+  }
+
+  int BackwardMatcher::stepSmall(std::uint64_t& set, int symbolClass) const{
+	const std::uint64_t* table = masks.data() + symbolClass * chunks * 256;
+	std::uint64_t next = 0;
+	for(std::size_t k = 0; k < chunks; ++k){
+		next |= table[k * 256 + ((set >> (8 * k)) & 255)];
+	}
+	set = next;
+	return !next ? 0 : (next & prefixes[0]) ? 2 : 1;
+  }
+
+  int BackwardMatcher::stepLarge(std::vector<std::uint64_t>& set, std::vector<std::uint64_t>& next, int symbolClass) const{
+	std::fill(next.begin(),next.end(),0);
+	const int* start = edgeStart.data() + symbolClass * nbStates;
+	for(std::size_t w = 0; w < set.size(); ++w){
+		for(std::uint64_t bits = set[w]; bits; bits &= bits - 1){
+			std::size_t q = w * 64 + __builtin_ctzll(bits);
+			for(int e = start[q]; e < start[q + 1]; ++e){
+				next[edgeTargets[e] / 64] |= std::uint64_t(1) << (edgeTargets[e] % 64);
+			}
+		}
+	}
+	set.swap(next);
+	int res = 0;
+	for(std::size_t w = 0; w < set.size(); ++w){
+		if(set[w] & prefixes[w]){
+			return 2;
+		}
+		res |= (set[w] != 0);
+	}
+	return res;
+  }
+
+  bool BackwardMatcher::startsAt(std::string_view text, std::size_t position) const{
+	int q = initial;
+	for(std::size_t i = position; !final[q]; ++i){
+		if(i == text.size()){
+			return false;
+		}
+		q = delta[classOf[(unsigned char)text[i]] * nbForward + q];
+		if(!q){
+			return false;
+		}
+	}
+	return true;
+  }
+
+  std::vector<std::size_t> BackwardMatcher::search(std::string_view text) const{
+	std::vector<std::size_t> positions;
+	if(!valid || empty || text.size() < window){
+		return positions;
+	}
+	if(window == 0){
+		for(std::size_t pos = 0; pos <= text.size(); ++pos){
+			positions.push_back(pos);
+		}
+		return positions;
+	}
+
+	// the window is shifted to the last prefix found before its start
+	auto scan = [&](auto reset, auto step){
+		std::size_t pos = 0;
+		while(pos + window <= text.size()){
+			reset();
+			std::size_t j = window;
+			std::size_t shift = window;
+			while(j > 0){
+				int read = step(classOf[(unsigned char)text[pos + --j]]);
+				if(!read){
+					break;
+				}
+				if(read == 2){
+					if(j > 0){
+						shift = j;
+					}else if(startsAt(text,pos)){
+						positions.push_back(pos);
+					}
+				}
+			}
+			pos += shift;
+		}
+	};
+
+	if(nbStates <= 64){
+		std::uint64_t all = (nbStates == 64) ? ~std::uint64_t(0) : (std::uint64_t(1) << nbStates) - 1;
+		std::uint64_t set = 0;
+		scan([&]{ set = all; },[&](int symbolClass){ return stepSmall(set,symbolClass); });
+	}else{
+		std::vector<std::uint64_t> all(prefixes.size(),~std::uint64_t(0));
+		if(nbStates % 64){
+			all.back() = (std::uint64_t(1) << (nbStates % 64)) - 1;
+		}
+		std::vector<std::uint64_t> set;
+		std::vector<std::uint64_t> next(all.size());
+		scan([&]{ set = all; },[&](int symbolClass){ return stepLarge(set,next,symbolClass); });
+	}
+	return positions;
+  }
 
 }
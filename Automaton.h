@@ -3,11 +3,19 @@
 
 #include <cstdlib>
 #include <cstddef> 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
+#include <bitset>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 
 
 
@@ -17,6 +25,102 @@ namespace fa {
 
   constexpr char Epsilon = '\0';
 
+  /**
+   * A transition, used by the bulk APIs
+   */
+  struct Transition {
+    int from;
+    char symbol;
+    int to;
+  };
+
+  /**
+   * The minimization algorithms, Auto lets createMinimal choose
+   */
+  enum class MinimizeAlgorithm {
+    Auto,
+    Moore,
+    Brzozowski,
+    Hopcroft,
+    Valmari,
+    Parallel,
+  };
+
+  /**
+   * What createMinimal did
+   */
+  struct MinimizeStats {
+    MinimizeAlgorithm algorithm = MinimizeAlgorithm::Auto;
+    double seconds = 0.0;
+  };
+
+  /**
+   * Options of createMinimal
+   */
+  struct MinimizeOptions {
+    MinimizeAlgorithm algorithm = MinimizeAlgorithm::Auto;
+    /**
+     * If not null, receive the chosen algorithm and the time spent
+     */
+    MinimizeStats* stats = nullptr;
+    /**
+     * Number of threads allowed, 0 for one by core
+     */
+    unsigned threads = 1;
+  };
+
+  /**
+   * Order in which the product of many automata combines them
+   */
+  enum class ProductOrder {
+    /**
+     * By rounds, the smallest with the next smallest
+     */
+    Smallest,
+    /**
+     * One after the other, the next sharing the fewest symbols with the current product
+     *
+     * The product only keeps the symbols common to both operands, so the fewer
+     * they share, the more transitions are cut and the smaller the product; with
+     * no common symbol, only the empty word can remain and emptiness is found at once.
+     */
+    AlphabetOverlap,
+  };
+
+  /**
+   * What the product of many automata did
+   */
+  struct ProductStats {
+    /**
+     * number of products of two automata computed
+     */
+    std::size_t products = 0;
+    /**
+     * number of states of the largest of them, before its reduction
+     */
+    std::size_t largestProduct = 0;
+  };
+
+  /**
+   * Options of the product of many automata
+   */
+  struct ProductOptions {
+    ProductOrder order = ProductOrder::Smallest;
+    /**
+     * Minimize the deterministic operands and intermediate products, and reduce the
+     * others by bisimulation. Otherwise they are only trimmed
+     */
+    bool minimize = true;
+    /**
+     * Number of threads computing independent products, 0 for one by core
+     */
+    unsigned threads = 1;
+    /**
+     * If not null, receive the number and the largest size of the intermediate products
+     */
+    ProductStats* stats = nullptr;
+  };
+
   class Automaton {
   public:
 
@@ -26,6 +130,39 @@ namespace fa {
      */
     Automaton();
 
+    /**
+     * Build an empty automaton whose storage is allocated from a memory resource.
+     *
+     * The resource must outlive the automaton. The automata created by the
+     * algorithms from this one are allocated from the same resource, while
+     * the temporaries of the algorithms live in a local arena.
+     */
+    explicit Automaton(std::pmr::memory_resource* resource);
+
+    /**
+     * Copy an automaton into storage allocated from a memory resource.
+     *
+     * The storage is shared if the resource is the one of the other automaton.
+     */
+    Automaton(const Automaton& other, std::pmr::memory_resource* resource);
+
+    /**
+     * Copy an automaton in O(1)
+     *
+     * The copies share their storage, which is cloned on the first modification.
+     * The storage stays allocated from the memory resource of the original.
+     */
+    Automaton(const Automaton& other) = default;
+    Automaton& operator=(const Automaton& other) = default;
+
+    Automaton(Automaton&& other) noexcept;
+    Automaton& operator=(Automaton&& other) noexcept;
+
+    /**
+     * Get the memory resource of the automaton
+     */
+    std::pmr::memory_resource* getMemoryResource() const;
+
     /**
      * Tell if an automaton is valid.
      *
@@ -66,6 +203,13 @@ namespace fa {
      */
     bool addState(int state);
 
+    /**
+     * Add several states to the automaton.
+     *
+     * Returns the number of states effectively added.
+     */
+    std::size_t addStates(const std::vector<int>& states);
+
     /**
      * Remove a state from the automaton.
      *
@@ -84,6 +228,21 @@ namespace fa {
      */
     std::size_t countStates() const;
 
+    /**
+     * Get the dense index of a state, between 0 and countStates() - 1.
+     *
+     * States are indexed in their order of addition and the indices are
+     * stable until a state is removed. Returns -1 if the state is not present.
+     */
+    int getStateIndex(int state) const;
+
+    /**
+     * Get the state with a dense index.
+     *
+     * Returns -1 if the index is out of range.
+     */
+    int getStateId(std::size_t index) const;
+
     /**
      * Set the state initial.
      */
@@ -112,6 +271,21 @@ namespace fa {
      */
     bool addTransition(int from, char alpha, int to);
 
+    /**
+     * Add several transitions
+     *
+     * Returns the number of transitions effectively added.
+     */
+    std::size_t addTransitions(const std::vector<Transition>& transitions);
+
+    /**
+     * Add several transitions where the states are given by their dense index
+     *
+     * This skips the translation of the state ids.
+     * Returns the number of transitions effectively added.
+     */
+    std::size_t addTransitionsByIndex(const std::vector<Transition>& transitions);
+
     /**
      * Remove a transition
      *
@@ -184,26 +358,147 @@ namespace fa {
      */
     bool match(const std::string& word) const;
 
+    /**
+     * Give the number of words of an acyclic deterministic automaton, 0 for other automata
+     *
+     * The automata with too many words for a std::size_t have no ranks either,
+     * so they give 0 and no index or word.
+     */
+    std::size_t countWords() const;
+
+    /**
+     * Give the rank of a word in the language of an acyclic deterministic automaton
+     *
+     * The ranks are dense and in lexicographic order, a minimal perfect hash of
+     * the words. The suffix counts of the states are computed on the first query
+     * and kept until the automaton is modified.
+     */
+    std::optional<std::size_t> wordToIndex(std::string_view word) const;
+
+    /**
+     * Give the word of a rank, the inverse of wordToIndex
+     */
+    std::optional<std::string> indexToWord(std::size_t index) const;
+
     /**
      * Tell if the langage accepted by the automaton is included in the
      * language accepted by the other automaton
      */
     bool isIncludedIn(const Automaton& other) const;
 
+    /**
+     * Mirror the automaton in place
+     *
+     * The states, the alphabet and the transition buffers are reused.
+     */
+    void mirror();
+
+    /**
+     * Complete the automaton in place, if not already complete
+     */
+    void complete();
+
+    /**
+     * Complement the automaton in place
+     */
+    void complement();
+
+    /**
+     * Determinize the automaton in place, if not already deterministic
+     */
+    void determinize();
+
+    /**
+     * Create an automaton accepting the union of the languages of two automata
+     *
+     * The states of lhs are numbered first, then those of rhs. No epsilon
+     * transition is added, the construction is in O(n + |T|).
+     */
+    static Automaton createUnion(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create an automaton accepting the concatenation of the languages of two automata
+     *
+     * The states of lhs are numbered first, then those of rhs, and a state merging
+     * the initial states of rhs if it has several. The transitions into a final
+     * state of lhs are doubled toward the start of rhs, so no epsilon transition
+     * is added. The construction is in O(n + |T|).
+     */
+    static Automaton createConcatenation(const Automaton& lhs, const Automaton& rhs);
+
+    /**
+     * Create an automaton accepting the Kleene star of the language of an automaton
+     *
+     * A new initial and final state merges the initial states, and the transitions
+     * into a final state are doubled toward it, so no epsilon transition is added.
+     * The construction is in O(n + |T|).
+     */
+    static Automaton createKleeneStar(const Automaton& other);
+
+    /**
+     * Create the position (Glushkov) automaton of a regular expression
+     *
+     * The syntax has literals, '.', classes like [a-z] or [^0-9], the escapes \d \w
+     * \D \W and '\' before one of \ | ( ) [ ] { } * + ? . ^ -, groups, '|', '*', '+',
+     * '?' and the bounded repetitions {m}, {m,} and {m,n}. '.' and the negations stand
+     * for the graphic characters not excluded. The state 0 is initial, then there is
+     * one state by position of a symbol, and no epsilon transition.
+     * A syntax error, another escape, or an expression of more than 2^20 nodes once
+     * its repetitions are expanded gives an invalid automaton, and so does one whose
+     * automaton would have more than 2^24 transitions, like a long chain of nullable
+     * factors where each position is followed by all the next ones.
+     */
+    static Automaton fromRegex(std::string_view regex);
+
+    /**
+     * Create the minimal acyclic automaton of words given in lexicographic order
+     *
+     * Built incrementally (Daciuk et al.): a state is minimized against a register
+     * as soon as the next words can not change it, so the memory stays close to
+     * the size of the result. The words are strings or string views; a word
+     * before the previous one, or with a character that can not be a symbol,
+     * gives an invalid automaton. The states are numbered in breadth-first order.
+     */
+    template<typename Iterator>
+    static Automaton fromSortedWords(Iterator first, Iterator last){
+      DawgBuilder builder;
+      for(; first != last; ++first){
+        if(!builder.add(*first)){
+          return Automaton();
+        }
+      }
+      return builder.finish();
+    }
+
+    /**
+     * Create the suffix automaton of a text, which accepts the factors of the text
+     *
+     * Online construction of Blumer et al., linear in the length n of the text,
+     * with at most 2n - 1 states and 3n - 4 transitions. Every state is final, so
+     * match tells if a word is a substring of the text. If given, occurrences
+     * receives for each state the size of its end position set, the number of
+     * occurrences of the words leading to it. A character of the text that can
+     * not be a symbol gives an invalid automaton.
+     */
+    static Automaton createSuffixAutomaton(std::string_view text, std::vector<std::size_t>* occurrences = nullptr);
+
     /**
      * Create a mirror automaton
      */
     static Automaton createMirror(const Automaton& automaton);
+    static Automaton createMirror(Automaton&& automaton);
 
     /**
      * Create a complete automaton, if not already complete
      */
     static Automaton createComplete(const Automaton& automaton);
+    static Automaton createComplete(Automaton&& automaton);
 
     /**
      * Create a complement automaton
      */
     static Automaton createComplement(const Automaton& automaton);
+    static Automaton createComplement(Automaton&& automaton);
 
     /**
      * Create the product of two automata
@@ -212,10 +507,42 @@ namespace fa {
      */
     static Automaton createProduct(const Automaton& lhs, const Automaton& rhs);
 
+    /**
+     * Create the product of two automata with a parallel breadth-first search
+     *
+     * Each level of pairs is shared between the threads, which find the new pairs
+     * in a sharded table and keep their transitions in their own buffers. These
+     * are merged by origin at the end and the states renumbered, so the result is
+     * the same as with createProduct.
+     * threads is the number of threads, 0 for one by core.
+     */
+    static Automaton createProductParallel(const Automaton& lhs, const Automaton& rhs, unsigned threads = 0);
+
+    /**
+     * Create the product of many automata
+     *
+     * The operands and the intermediate products are reduced, and combined in
+     * the order of the options. As soon as one of them has an empty language,
+     * the result is an automaton with an empty language. With ProductOrder::Smallest,
+     * the products of a round are computed in parallel if several threads are allowed.
+     */
+    static Automaton createProduct(const std::vector<Automaton>& automata, ProductOptions options = ProductOptions());
+
     /**
      * Create a deterministic automaton, if not already deterministic
      */
     static Automaton createDeterministic(const Automaton& other);
+    static Automaton createDeterministic(Automaton&& other);
+
+    /**
+     * Create a deterministic automaton with a parallel subset construction
+     *
+     * The threads take the subsets to expand from work-stealing queues and intern
+     * the new ones in a sharded table. The states are then renumbered, so the
+     * result is the same as with createDeterministic.
+     * threads is the number of threads, 0 for one by core.
+     */
+    static Automaton createDeterministicParallel(const Automaton& other, unsigned threads = 0);
 
     /**
      * Create an equivalent minimal automaton with the Moore algorithm
@@ -226,64 +553,702 @@ namespace fa {
      * Create an equivalent minimal automaton with the Brzozowski algorithm
      */
     static Automaton createMinimalBrzozowski(const Automaton& other);
+    static Automaton createMinimalBrzozowski(Automaton&& other);
+
+    /**
+     * Create an equivalent minimal automaton with the Hopcroft algorithm
+     *
+     * The automaton is made accessible, deterministic and complete, then
+     * refined in O(|Σ| n log n). The states are numbered in breadth-first order.
+     */
+    static Automaton createMinimalHopcroft(const Automaton& other);
+
+    /**
+     * Create an equivalent minimal partial automaton with the Valmari-Lehtinen algorithm
+     *
+     * The automaton is made accessible, deterministic and co-accessible, then
+     * refined in O(|T| log n) without being completed: the result has no bin
+     * state. The states are numbered in breadth-first order.
+     */
+    static Automaton createMinimalValmari(const Automaton& other);
+
+    /**
+     * Create an equivalent minimal automaton by a parallel signature refinement
+     *
+     * The automaton is made accessible, deterministic and complete. At each round
+     * the states compute their signature (class, classes of the successors) in
+     * parallel, and the classes are renumbered through a concurrent hash table,
+     * until no class splits. The result is the same as with Hopcroft.
+     * threads is the number of threads, 0 for one by core.
+     */
+    static Automaton createMinimalParallel(const Automaton& other, unsigned threads = 0);
+
+    /**
+     * Create an equivalent minimal automaton
+     *
+     * With MinimizeAlgorithm::Auto, the algorithm is chosen from the size,
+     * the determinism, the size of the alphabet, an estimation of the
+     * blowup of the determinization and the number of threads allowed.
+     * The result is complete, except when Valmari is asked explicitly, which gives
+     * a partial automaton without bin state. Auto only chooses among the algorithms
+     * giving a complete automaton; for a sparse automaton whose completion would be
+     * costly and a partial result is enough, ask for Valmari.
+     */
+    static Automaton createMinimal(const Automaton& other, MinimizeOptions options = MinimizeOptions());
+
+    /**
+     * Create an equivalent automaton, smaller but not canonical, without determinization
+     *
+     * The states equivalent for the forward simulation are merged and the transitions
+     * to a state simulated by another target of the same key are pruned, then the same
+     * is done with the backward simulation. The states keep the id of the first state
+     * of their class.
+     */
+    static Automaton createReducedBySimulation(const Automaton& other);
+
+    /**
+     * Create the quotient of an automaton by its coarsest forward bisimulation
+     *
+     * Computed with the Paige-Tarjan algorithm in O(|T| log n). The states keep
+     * the id of the first state of their class. This is also done before the
+     * subset construction of createDeterministic.
+     */
+    static Automaton createBisimulationQuotient(const Automaton& other);
 
 
   private:
+	friend class Scanner;
+	friend class BackwardMatcher;
+
 	/**
-	 * Depth-first search (DFS) is an algorithm for traversing or searching tree or graph data structures 
+	 * Small vector of dense targets
+	 *
+	 * The first targets are stored inline, so that the transitions of a
+	 * deterministic automaton never allocate.
 	 */
-	bool DepthFirstSearch(bool emptyChoice,std::set<int>& v,int s )const;
-	
+	class TargetList {
+	public:
+	  TargetList(int target, std::pmr::memory_resource* resource) : resource(resource), count(1), capacity(InlineCapacity) { storage.local[0] = target; }
+	  TargetList(const TargetList& other) : TargetList(other,other.resource) {}
+	  TargetList(const TargetList& other, std::pmr::memory_resource* resource);
+	  TargetList(TargetList&& other) noexcept;
+	  TargetList(TargetList&& other, std::pmr::memory_resource* resource);
+	  TargetList& operator=(const TargetList& other);
+	  TargetList& operator=(TargetList&& other);
+	  ~TargetList();
+
+	  std::size_t size() const { return count; }
+	  bool empty() const { return count == 0; }
+	  int* begin() { return data(); }
+	  int* end() { return data() + count; }
+	  const int* begin() const { return data(); }
+	  const int* end() const { return data() + count; }
+	  int front() const { return data()[0]; }
+
+	  void push_back(int target);
+	  int* erase(int* first, int* last);
+	  int* erase(int* position) { return erase(position,position + 1); }
+
+	private:
+	  static constexpr std::uint32_t InlineCapacity = 2;
+
+	  bool isInline() const { return capacity == InlineCapacity; }
+	  int* data() { return isInline() ? storage.local : storage.heap; }
+	  const int* data() const { return isInline() ? storage.local : storage.heap; }
+	  void release();
+
+	  union {
+	    int local[InlineCapacity];
+	    int* heap;
+	  } storage;
+	  std::pmr::memory_resource* resource;
+	  std::uint32_t count;
+	  std::uint32_t capacity;
+	};
+
+	/**
+	 * The out-edges of a state for one symbol (or Epsilon), targets are dense indices
+	 *
+	 * Allocator-aware, so that the targets use the memory resource of the enclosing container.
+	 */
+	struct Edge {
+	  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+	  Edge(char symbol, int target, const allocator_type& alloc) : symbol(symbol), targets(target,alloc.resource()) {}
+	  Edge(const Edge& other, const allocator_type& alloc) : symbol(other.symbol), targets(other.targets,alloc.resource()) {}
+	  Edge(Edge&& other, const allocator_type& alloc) : symbol(other.symbol), targets(std::move(other.targets),alloc.resource()) {}
+	  Edge(const Edge& other) = default;
+	  Edge(Edge&& other) noexcept = default;
+	  Edge& operator=(const Edge& other) = default;
+	  Edge& operator=(Edge&& other) = default;
+
+	  char symbol;
+	  TargetList targets;
+	};
+
+	/**
+	 * Incremental construction of the minimal automaton of sorted words
+	 *
+	 * The states on the path of the last word can still change, the others are
+	 * frozen in compact arrays and unique for their finality and out-edges.
+	 */
+	class DawgBuilder {
+	public:
+	  DawgBuilder();
+
+	  /**
+	   * Add the next word, false if it is before the previous one or not made of symbols
+	   */
+	  bool add(std::string_view word);
+
+	  /**
+	   * Freeze the last path and give the automaton
+	   */
+	  Automaton finish();
+
+	private:
+	  struct PathState {
+	    bool final;
+	    std::vector<std::pair<char,int>> edges;
+	  };
+
+	  struct FrozenHash {
+	    const DawgBuilder* builder;
+	    std::size_t operator()(int state) const;
+	  };
+
+	  struct FrozenEqual {
+	    const DawgBuilder* builder;
+	    bool operator()(int lhs, int rhs) const;
+	  };
+
+	  /**
+	   * Freeze the states of the path after a depth, replacing them by their
+	   * equivalent in the register if any
+	   */
+	  void freeze(std::size_t depth);
+
+	  /**
+	   * Freeze one state, returns its number in the register
+	   */
+	  int freeze(const PathState& state);
+
+	  std::string previous;
+	  std::vector<PathState> path;
+	  std::vector<bool> finals;
+	  std::vector<int> edgeStart;
+	  std::vector<char> edgeSymbols;
+	  std::vector<int> edgeTargets;
+	  std::unordered_set<int,FrozenHash,FrozenEqual> frozen;
+	};
+
+	/**
+	 * Build the product of two automata with the result allocated from a memory resource
+	 */
+	static Automaton createProduct(const Automaton& lhs, const Automaton& rhs, std::pmr::memory_resource* resource);
+
+	/**
+	 * Build the deterministic automaton of the mirror without building the mirror,
+	 * by a subset construction on the predecessors. The empty subset is trimmed,
+	 * unless it is the initial state.
+	 */
+	static Automaton createReverseDeterministic(const Automaton& other, std::pmr::memory_resource* resource);
+
+	/**
+	 * Choose the minimization algorithm used by createMinimal with MinimizeAlgorithm::Auto
+	 */
+	MinimizeAlgorithm chooseMinimizeAlgorithm(unsigned threads) const;
+
+	/**
+	 * Quotient the automaton by its forward simulation equivalence and prune
+	 * the transitions and initial states that are simulated by a sibling
+	 */
+	void reduceBySimulation();
+
+	/**
+	 * Build the bisimulation quotient with the result allocated from a memory resource
+	 */
+	static Automaton createBisimulationQuotient(const Automaton& other, std::pmr::memory_resource* resource);
+
+	/**
+	 * Add a state that is not present yet, returns its dense index
+	 */
+	int appendState(int state);
+
+	/**
+	 * Append the states and transitions of another automaton, without the initial
+	 * and final flags. Its dense states are shifted by the current number of states
+	 * and become the ids, so the ids of this automaton must be its dense indices.
+	 * Returns the shift.
+	 */
+	int appendAutomaton(const Automaton& other);
+
+	/**
+	 * Remove the states marked in a mask of dense indices and compact the storage
+	 */
+	void removeStates(const std::pmr::vector<bool>& removed);
+
+	/**
+	 * Recompute the counters from the transitions
+	 */
+	void recount();
+
+	/**
+	 * Give the targets of a dense state for a symbol, nullptr if there is none
+	 */
+	const TargetList* findTargets(int from, char alpha) const;
+
+	/**
+	 * Add a transition between dense states if not already present
+	 */
+	bool insertTransition(int from, char alpha, int to);
+
+	/**
+	 * Add a transition between dense states, the caller ensures it is not already present
+	 */
+	void appendTransition(int from, char alpha, int to);
+
+	/**
+	 * Remove a transition between dense states
+	 */
+	bool eraseTransition(int from, char alpha, int to);
+
+	/**
+	 * Mark the dense states reachable from a list of dense states
+	 */
+	std::pmr::vector<bool> reachableFrom(const std::pmr::vector<int>& from, std::pmr::memory_resource* resource) const;
+
+	/**
+	 * Give the dense initial states
+	 */
+	std::pmr::vector<int> denseInitialStates(std::pmr::memory_resource* resource) const;
+
+	/**
+	 * Give the dense states sorted by state id
+	 */
+	std::vector<int> sortedStates() const;
+
+	/**
+	 * Compute the dense states reached by reading a char from a list of dense states,
+	 * mark is a scratch buffer of countStates() elements, all false on entry and on exit
+	 */
+	void readSymbol(const std::pmr::vector<int>& from, char a, std::pmr::vector<int>& to, std::pmr::vector<bool>& mark) const;
+
+	/**
+	 * Compute the dense states reached by reading a word
+	 */
+	std::pmr::vector<int> readDense(const std::string& word, std::pmr::memory_resource* resource) const;
+
 	/**
 	 * Find if a bin state already exist in a automaton
+	 *
+	 * The answer is cached and kept up to date by the editing methods,
+	 * returns the dense index of the bin state or -1 if there is none.
 	 */
 	int findBinState() const;
 
 	/**
-	 * give a set of all final state
+	 * Tell if a dense state is a bin state (not final and all its transitions loop on itself),
+	 * in one pass over its out-edges
+	 */
+	bool isBinState(int state) const;
+
+	/**
+	 * Update the cached bin state after the out-edges of a dense state changed
 	 */
-	std::set<int> getFinalState() const;
+	void refreshBinState(int state);
 
 	/**
-	 * give a set of all initial state
+	 * give the sorted list of all final state, maintained by the editing methods
 	 */
-	std::set<int> getInitialState() const;
+	const std::pmr::vector<int>& getFinalState() const;
 
 	/**
-	 * give a set of state who can be read the char from a set of state
+	 * give the sorted list of all initial state, maintained by the editing methods
 	 */
-	std::set<int> readSymbols(const std::set<int> sete,char a) const;
+	const std::pmr::vector<int>& getInitialState() const;
 
 	/**
-	 * print the tab for minimal moore debug
+	 * flags of a state, packed in one byte
 	 */
-	static void printMinimalMooreStepTab(std::vector<std::pair<char,std::vector<int>>> nZero,int& count);
+    enum StateFlag : unsigned char {
+      StateInitial = 1,
+      StateFinal = 2,
+    };
 
 	/**
-	 * fill all line of the tab of minimal moore algo
+	 * Word counts of an acyclic deterministic automaton, for the ranks of its words
 	 */
-	static std::vector<std::pair<char,std::vector<int>>> rempliTableauMoor(const Automaton& copy,std::vector<std::pair<char,std::vector<int>>> n,std::vector<int> sta);
+	struct WordIndex {
+	/**
+	 * the automaton is acyclic, deterministic and its number of words fits in a size_t
+	 */
+	  bool ranked = false;
+	  int initial = -1;
+	/**
+	 * position of the first out-edge of each dense state in before, plus the end
+	 */
+	  std::vector<std::size_t> start;
+	/**
+	 * for each out-edge, the words of its state before it: the empty word if
+	 * the state is final and the suffixes through the previous symbols
+	 */
+	  std::vector<std::size_t> before;
+	/**
+	 * number of words accepted from each dense state
+	 */
+	  std::vector<std::size_t> suffixes;
+	};
 
 	/**
-	 * fill the firt line a minimal moore tab
+	 * Contents of an automaton, shared between the copies
 	 */
-	static std::vector<int> returnLigne0Tab(std::vector<std::pair<char,std::vector<int>>> tabAvant);
-	
+	struct Storage {
+	  explicit Storage(std::pmr::memory_resource* resource);
+	  Storage(const Storage& other, std::pmr::memory_resource* resource);
+
 	/**
 	 * set of char for the alphabet
 	 */
-    std::set<char> alphabet;
+    std::pmr::set<char> alphabet;
+
+	/**
+	 * dense index of each state id
+	 */
+    std::pmr::unordered_map<int,int> index;
 
 	/**
-	 * map with an int for the state and a pair of bool to know if hes initial or final
+	 * state id of each dense index
+	 */
+    std::pmr::vector<int> ids;
+
+	/**
+	 * flags of each dense state to know if hes initial or final
+	 */
+    std::pmr::vector<unsigned char> flags;
+
+	/**
+	 * out-edges of each dense state, sorted by symbol
+	 */
+    std::pmr::vector<std::pmr::vector<Edge>> edges;
+
+	/**
+	 * sorted lists of the initial and final state ids
+	 */
+    std::pmr::vector<int> initialStates;
+    std::pmr::vector<int> finalStates;
+
+	/**
+	 * counters maintained by the editing methods so that the structural queries are O(1)
+	 */
+    std::size_t nbTransitions;
+	/**
+	 * number of keys (state, char) with more than one target
+	 */
+    std::size_t nbNonDeterministicKeys;
+	/**
+	 * number of keys (state, symbol) with a symbol of the alphabet,
+	 * the missing slots for completeness are countStates() * countSymbols() - nbFilledSlots
+	 */
+    std::size_t nbFilledSlots;
+	/**
+	 * word counts built by the first rank query, dropped on every modification
+	 */
+    mutable std::shared_ptr<const WordIndex> words;
+	};
+
+	/**
+	 * Give the word counts, built and kept in the storage if needed
+	 */
+	std::shared_ptr<const WordIndex> wordIndex() const;
+
+	/**
+	 * Give the storage to modify, cloned first if it is shared with another automaton
+	 */
+	Storage& mut();
+
+	/**
+	 * Give the storage of empty automata left behind by a move
+	 */
+	static const std::shared_ptr<Storage>& emptyStorage();
+
+	/**
+	 * storage of the automaton, never null
+	 */
+    std::shared_ptr<Storage> shared;
+
+	/**
+	 * cached dense bin state (-1 if none), only meaningful when binStateKnown is true
+	 */
+    mutable int cachedBinState;
+    mutable bool binStateKnown;
+
+  };
+
+  /**
+   * Run many automata together on the same words, without building their product
+   *
+   * Each automaton is compiled into a minimal partial DFA. All the states are
+   * numbered in one table, with a shared dead state, and the transitions of a
+   * symbol are contiguous: a step of all the automata is a gather in one row,
+   * that the compiler can vectorize.
+   */
+  class Scanner {
+  public:
+    /**
+     * Compile a list of automata
+     */
+    explicit Scanner(const std::vector<Automaton>& automata);
+
+    /**
+     * Get the number of automata
+     */
+    std::size_t countAutomata() const;
+
+    /**
+     * Tell which automata accept a word: the bit i % 64 of the element i / 64
+     * is set if the i-th automaton accepts the word
+     */
+    std::vector<std::uint64_t> match(const std::string& word) const;
+
+  private:
+	/**
+	 * number of states of all the automata, the dead state 0 included
 	 */
-    std::map<int,std::pair<bool,bool>> states;
+    std::size_t nbStates;
 
 	/**
-	 * map with pair in key for transition state and char to several state (vector<int>)
+	 * class of each byte, 0 for those of no alphabet
 	 */
-    std::map<std::pair<int,char>,std::vector<int>> transitions;
+    std::vector<int> classOf;
 
+	/**
+	 * next states, by class of symbol then by state
+	 */
+    std::vector<int> delta;
+
+	/**
+	 * finality of each state
+	 */
+    std::vector<unsigned char> final;
+
+	/**
+	 * initial state of each automaton
+	 */
+    std::vector<int> initial;
+  };
+
+  /**
+   * Regular expression matched by a lazy DFA of Brzozowski derivatives
+   *
+   * The expressions are hash-consed terms, simplified by their constructors so
+   * that equivalent derivatives are often the same term. The states are derived
+   * on demand by match, and the transitions are memoized by class of symbols.
+   * The syntax is the one of Automaton::fromRegex.
+   * The terms made and the steps of derivation are counted, and a matcher that
+   * needs more than 2^22 of them becomes invalid instead of exhausting the memory.
+   */
+  class LazyRegex {
+  public:
+    /**
+     * Parse a regular expression, nothing is derived yet
+     */
+    explicit LazyRegex(std::string_view regex);
+
+    /**
+     * Tell if the expression was parsed without syntax error and its derivations
+     * stayed within the budget of work
+     */
+    bool isValid() const;
+
+    /**
+     * Tell if a word is in the language, deriving the missing states. False once
+     * the matcher is invalid
+     */
+    bool match(const std::string& word);
+
+    /**
+     * Get the number of states derived so far
+     */
+    std::size_t countStates() const;
+
+    /**
+     * Derive all the states and give the complete DFA, numbered in breadth-first
+     * order. An invalid expression gives an invalid automaton
+     */
+    Automaton toAutomaton();
+
+  private:
+	enum Kind : unsigned char {
+	  Nothing,
+	  Empty,
+	  Symbols,
+	  Concat,
+	  Alt,
+	  Star,
+	};
+
+	/**
+	 * a term, Symbols has its set in lhs and Star its operand
+	 */
+	struct Term {
+	  Kind kind;
+	  bool nullable;
+	  int lhs;
+	  int rhs;
+	};
+
+	/**
+	 * fields of a term identifying it in the hash-consing table
+	 */
+	struct TermKey {
+	  Kind kind;
+	  int lhs;
+	  int rhs;
+
+	  bool operator==(const TermKey& other) const { return kind == other.kind && lhs == other.lhs && rhs == other.rhs; }
+	};
+
+	struct TermKeyHash {
+	  std::size_t operator()(const TermKey& key) const;
+	};
+
+	/**
+	 * the hash-consed term with these fields
+	 */
+	int make(Kind kind, int lhs, int rhs);
+
+	/**
+	 * smart constructors, simplifying with the neutral and absorbing terms;
+	 * concatenations are right-nested, alternatives sorted and unique
+	 */
+	int concat(int lhs, int rhs);
+	int alt(int lhs, int rhs);
+	int alt(const std::vector<int>& operands);
+	int star(int term);
+
+	/**
+	 * count n more steps of work, false once the budget is spent
+	 */
+	bool spend(std::size_t n);
+
+	/**
+	 * the derivative of a term by the symbols of a class, memoized
+	 */
+	int derive(int term, int symbolClass);
+
+	/**
+	 * the state of a term, added if new
+	 */
+	int stateOf(int term);
+
+	/**
+	 * the state after reading a class of symbols, derived if unknown
+	 */
+	int step(int state, int symbolClass);
+
+    std::vector<Term> terms;
+    std::unordered_map<TermKey,int,TermKeyHash> index;
+    std::unordered_map<std::uint64_t,int> derivatives;
+    std::vector<std::bitset<256>> sets;
+    std::size_t work;
+    int nothing;
+    int empty;
+
+	/**
+	 * class of each byte, one byte of each class, and the symbols of the sets
+	 */
+    std::vector<int> classOf;
+    std::vector<char> representative;
+    std::vector<char> alphabet;
+
+	/**
+	 * marks of the terms while flattening alternatives, all clear between the calls
+	 */
+    std::vector<unsigned char> marks;
+
+	/**
+	 * the lazy DFA: term of each state and known transitions by class (-1 if not derived)
+	 */
+    int start;
+    std::size_t nbClasses;
+    std::unordered_map<int,int> states;
+    std::vector<int> termOf;
+    std::vector<int> next;
+  };
+
+  /**
+   * Search of the words of a language in texts by backward DAWG matching
+   *
+   * The windows have the length of the shortest word and are read right to left
+   * with the factor automaton of the mirror, so most of the text is skipped when
+   * the words are long. The state sets are bit masks updated by byte tables
+   * (BNDM) when the mirror has at most 64 states, sparse bit sets otherwise.
+   * The candidates are checked forward with the minimal automaton.
+   */
+  class BackwardMatcher {
+  public:
+    /**
+     * Compile an automaton, its epsilon transitions are ignored
+     */
+    explicit BackwardMatcher(const Automaton& automaton);
+
+    /**
+     * Tell if the automaton was valid
+     */
+    bool isValid() const;
+
+    /**
+     * Get the length of the windows, the length of the shortest word
+     */
+    std::size_t getWindow() const;
+
+    /**
+     * Give the sorted positions of the text where a word of the language starts
+     */
+    std::vector<std::size_t> search(std::string_view text) const;
+
+  private:
+	/**
+	 * Read a class of symbols backward from a set of states of the mirror,
+	 * returns 0 if the set becomes empty, 2 if it has a prefix of a word, 1 otherwise
+	 */
+    int stepSmall(std::uint64_t& set, int symbolClass) const;
+    int stepLarge(std::vector<std::uint64_t>& set, std::vector<std::uint64_t>& next, int symbolClass) const;
+
+	/**
+	 * Tell if a word of the language starts at a position of the text
+	 */
+    bool startsAt(std::string_view text, std::size_t position) const;
+
+    bool valid;
+    bool empty;
+    std::size_t window;
+
+	/**
+	 * class of each byte, 0 for those of no alphabet
+	 */
+    std::vector<int> classOf;
+    std::size_t nbClasses;
+
+	/**
+	 * the mirror: its final states, the byte tables of the successors of the
+	 * sets of 8 states by class, or the successors of each state by class
+	 */
+    std::size_t nbStates;
+    std::size_t chunks;
+    std::vector<std::uint64_t> prefixes;
+    std::vector<std::uint64_t> masks;
+    std::vector<int> edgeStart;
+    std::vector<int> edgeTargets;
+
+	/**
+	 * the minimal automaton with the dead state 0: next states by class then state
+	 */
+    std::size_t nbForward;
+    std::vector<int> delta;
+    std::vector<unsigned char> final;
+    int initial;
   };
 
 }
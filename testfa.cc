@@ -49,6 +49,91 @@ TEST(Automaton, Empty) {
   EXPECT_FALSE(fa.isValid());
 }
 
+TEST(Automaton, MemoryResource) {
+  std::pmr::monotonic_buffer_resource arena;
+  fa::Automaton fa(&arena);
+  EXPECT_EQ(fa.getMemoryResource(),&arena);
+  EXPECT_TRUE(fa.addSymbol('a'));
+  EXPECT_TRUE(fa.addState(0));
+  EXPECT_TRUE(fa.addState(1));
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+  EXPECT_TRUE(fa.addTransition(0,'a',0));
+  EXPECT_TRUE(fa.addTransition(1,'a',0));
+
+  fa::Automaton det = fa::Automaton::createDeterministic(fa);
+  EXPECT_EQ(det.getMemoryResource(),&arena);
+  EXPECT_TRUE(det.match("a"));
+  EXPECT_FALSE(det.match(""));
+
+  fa::Automaton copy = fa;
+  EXPECT_EQ(copy.getMemoryResource(),&arena);
+  EXPECT_TRUE(copy.hasTransition(0,'a',1));
+}
+
+TEST(Automaton, CopyToMemoryResource) {
+  fa::Automaton fa;
+  EXPECT_TRUE(fa.addSymbol('a'));
+  EXPECT_TRUE(fa.addState(0));
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  for(int i = 1; i < 5; ++i){
+    EXPECT_TRUE(fa.addState(i));
+    EXPECT_TRUE(fa.addTransition(0,'a',i));
+  }
+
+  std::pmr::monotonic_buffer_resource arena;
+  fa::Automaton copy(fa,&arena);
+  EXPECT_EQ(copy.getMemoryResource(),&arena);
+  EXPECT_EQ(copy.countTransitions(),4u);
+  EXPECT_TRUE(copy.hasTransition(0,'a',4));
+  EXPECT_TRUE(copy.isStateInitial(0));
+  EXPECT_TRUE(copy.match(""));
+}
+
+TEST(Automaton, CopyThenModify) {
+  fa::Automaton fa;
+  static const std::vector<char> tab = {'a','b'};
+  createAutomaton(fa,2,tab);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+
+  fa::Automaton copy = fa;
+  EXPECT_TRUE(copy.addTransition(1,'b',0));
+  EXPECT_TRUE(copy.removeState(1));
+  EXPECT_TRUE(copy.addState(7));
+  copy.setStateFinal(7);
+
+  EXPECT_EQ(2u,fa.countStates());
+  EXPECT_EQ(1u,fa.countTransitions());
+  EXPECT_TRUE(fa.hasTransition(0,'a',1));
+  EXPECT_FALSE(fa.hasState(7));
+  EXPECT_TRUE(fa.match("a"));
+
+  EXPECT_FALSE(copy.hasState(1));
+  EXPECT_TRUE(copy.isStateFinal(7));
+  EXPECT_EQ(0u,copy.countTransitions());
+}
+
+TEST(Automaton, ModifyOriginalAfterCopy) {
+  fa::Automaton fa;
+  static const std::vector<char> tab = {'a'};
+  createAutomaton(fa,2,tab);
+  fa.setStateInitial(0);
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+
+  fa::Automaton copy = fa;
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.removeSymbol('a'));
+
+  EXPECT_FALSE(copy.isStateFinal(1));
+  EXPECT_TRUE(copy.hasSymbol('a'));
+  EXPECT_TRUE(copy.hasTransition(0,'a',1));
+  EXPECT_EQ(0u,fa.countTransitions());
+}
+
 /*
  * isValid
  */
@@ -214,6 +299,40 @@ TEST(removeState, InvalidSymbol) {
   EXPECT_EQ(1u,fa.countStates());
 }
 
+/*
+ * addStates
+ */
+TEST(addStates, SparseStates) {
+  fa::Automaton fa;
+  EXPECT_EQ(3u,fa.addStates({1000003,2000017,5}));
+  EXPECT_EQ(1u,fa.addStates({5,-1,7}));
+  EXPECT_EQ(4u,fa.countStates());
+  EXPECT_TRUE(fa.hasState(2000017));
+  EXPECT_FALSE(fa.isStateFinal(2000017));
+}
+
+/*
+ * getStateIndex
+ */
+TEST(getStateIndex, SparseStates) {
+  fa::Automaton fa;
+  EXPECT_EQ(3u,fa.addStates({1000003,2000017,5}));
+  EXPECT_EQ(0,fa.getStateIndex(1000003));
+  EXPECT_EQ(2,fa.getStateIndex(5));
+  EXPECT_EQ(-1,fa.getStateIndex(4));
+  EXPECT_EQ(2000017,fa.getStateId(1));
+  EXPECT_EQ(-1,fa.getStateId(3));
+}
+
+TEST(getStateIndex, AfterRemovedState) {
+  fa::Automaton fa;
+  EXPECT_EQ(3u,fa.addStates({1000003,2000017,5}));
+  EXPECT_TRUE(fa.removeState(1000003));
+  EXPECT_EQ(0,fa.getStateIndex(2000017));
+  EXPECT_EQ(1,fa.getStateIndex(5));
+  EXPECT_EQ(5,fa.getStateId(1));
+}
+
 /*
  * hasState
  */
@@ -373,6 +492,28 @@ TEST(addTransition, SecondStateNotExist) {
   EXPECT_FALSE(fa.hasTransition(0,'a',1));
 }
 
+/*
+ * addTransitions
+ */
+TEST(addTransitions, SparseStates) {
+  fa::Automaton fa;
+  EXPECT_TRUE(fa.addSymbol('a'));
+  EXPECT_EQ(2u,fa.addStates({1000003,2000017}));
+  EXPECT_EQ(2u,fa.addTransitions({{1000003,'a',2000017},{2000017,'a',2000017},{1000003,'a',2000017},{1000003,'b',2000017}}));
+  EXPECT_TRUE(fa.hasTransition(1000003,'a',2000017));
+  EXPECT_EQ(2u,fa.countTransitions());
+}
+
+TEST(addTransitions, ByIndex) {
+  fa::Automaton fa;
+  EXPECT_TRUE(fa.addSymbol('a'));
+  EXPECT_EQ(2u,fa.addStates({1000003,2000017}));
+  EXPECT_EQ(2u,fa.addTransitionsByIndex({{0,'a',1},{1,'a',1},{1,'a',2}}));
+  EXPECT_TRUE(fa.hasTransition(1000003,'a',2000017));
+  EXPECT_TRUE(fa.hasTransition(2000017,'a',2000017));
+  EXPECT_EQ(2u,fa.countTransitions());
+}
+
 /*
  * Remove a transition
  */
@@ -463,6 +604,28 @@ TEST(removeTransition,OriginRemove){
 	EXPECT_TRUE(fa.hasTransition(1,'a',1));
 }
 
+TEST(removeTransition, ManyTargets) {
+  fa::Automaton fa;
+
+  static const std::vector<char> tab = {'a'};
+  createAutomaton(fa,10,tab);
+
+  for(int i = 0 ; i < 10 ; ++i){
+    EXPECT_TRUE(fa.addTransition(0,'a',i));
+  }
+  EXPECT_EQ(10u,fa.countTransitions());
+  EXPECT_TRUE(fa.removeTransition(0,'a',0));
+  EXPECT_TRUE(fa.removeTransition(0,'a',5));
+  EXPECT_FALSE(fa.hasTransition(0,'a',5));
+  EXPECT_TRUE(fa.hasTransition(0,'a',9));
+
+  fa::Automaton copy = fa;
+  EXPECT_TRUE(fa.removeState(9));
+  EXPECT_TRUE(copy.hasTransition(0,'a',9));
+  EXPECT_EQ(8u,copy.countTransitions());
+  EXPECT_EQ(7u,fa.countTransitions());
+}
+
 /*
  * hasTransition
  */
@@ -553,6 +716,24 @@ TEST(isDeterministic, TransitionError) {
   EXPECT_FALSE(fa.isDeterministic());
 }
 
+TEST(isDeterministic, RemovedState) {
+  fa::Automaton fa;
+
+  static const std::vector<char> tab = {'a'};
+  createAutomaton(fa,3,tab);
+  fa.setStateInitial(0);
+  fa.setStateInitial(2);
+
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+  EXPECT_TRUE(fa.addTransition(0,'a',2));
+  EXPECT_FALSE(fa.isDeterministic());
+  EXPECT_EQ(2u,fa.countTransitions());
+
+  EXPECT_TRUE(fa.removeState(2));
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_EQ(1u,fa.countTransitions());
+}
+
 
 
 /*
@@ -613,6 +794,30 @@ TEST(isComplete, AddedRemovedTransition){
 
 }
 
+TEST(isComplete, AddedStateAndSymbol){
+	fa::Automaton fa;
+
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(fa,1,tab);
+
+	EXPECT_TRUE(fa.addTransition(0,'a',0));
+	EXPECT_TRUE(fa.isComplete());
+
+	EXPECT_TRUE(fa.addSymbol('b'));
+	EXPECT_FALSE(fa.isComplete());
+	EXPECT_TRUE(fa.addTransition(0,'b',0));
+	EXPECT_TRUE(fa.isComplete());
+
+	EXPECT_TRUE(fa.addState(1));
+	EXPECT_FALSE(fa.isComplete());
+	EXPECT_TRUE(fa.removeState(1));
+	EXPECT_TRUE(fa.isComplete());
+
+	EXPECT_TRUE(fa.removeSymbol('b'));
+	EXPECT_TRUE(fa.isComplete());
+	EXPECT_EQ(1u,fa.countTransitions());
+}
+
 /**
   createComplete
 */
@@ -661,6 +866,56 @@ TEST(createComplete, noComplet) {
 
 }
 
+TEST(createComplete, reuseBinState) {
+  fa::Automaton fa;
+
+  static const std::vector<char> tab = {'a','b'};
+  createAutomaton(fa,3,tab);
+
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+  EXPECT_TRUE(fa.addTransition(0,'b',2));
+  EXPECT_TRUE(fa.addTransition(2,'a',2));
+  EXPECT_FALSE(fa.isComplete());
+
+  fa::Automaton complete = fa.createComplete(fa);
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(3u,complete.countStates());
+  EXPECT_TRUE(complete.hasTransition(1,'a',2));
+
+  // state 2 is no longer a bin state
+  EXPECT_TRUE(fa.addTransition(2,'b',0));
+  complete = fa.createComplete(fa);
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(4u,complete.countStates());
+  EXPECT_TRUE(complete.match("bba"));
+  EXPECT_FALSE(complete.match("bab"));
+
+  // and it is a bin state again
+  EXPECT_TRUE(fa.removeTransition(2,'b',0));
+  complete = fa.createComplete(fa);
+  EXPECT_EQ(3u,complete.countStates());
+}
+
+TEST(complete, InPlace) {
+  fa::Automaton fa;
+  static const std::vector<char> tab = {'a','b'};
+  createAutomaton(fa,2,tab);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+
+  fa.complete();
+
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_EQ(3u,fa.countStates());
+  EXPECT_EQ(6u,fa.countTransitions());
+  EXPECT_TRUE(fa.match("a"));
+  EXPECT_FALSE(fa.match("ab"));
+}
+
 
 /**
   create a complement automate 
@@ -848,6 +1103,25 @@ TEST(createComplement,Complement2Times){
 	EXPECT_FALSE(fa.match("bac"));
 }
 
+TEST(complement,InPlace){
+  fa::Automaton fa;
+  static const std::vector<char> tab = {'a','b'};
+  createAutomaton(fa,2,tab);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.addTransition(0,'a',1));
+  EXPECT_TRUE(fa.addTransition(0,'a',0));
+
+  fa.complement();
+
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_FALSE(fa.match("a"));
+  EXPECT_FALSE(fa.match("aa"));
+  EXPECT_TRUE(fa.match(""));
+  EXPECT_TRUE(fa.match("b"));
+}
+
 
 
 
@@ -938,111 +1212,550 @@ TEST(createMirror, stateInitioFinal){
 	
 }
 
-/**
- * isLanguageEmpty
- */ 
-TEST(isLanguageEmpty, validNoInitialState){
+TEST(mirror, InPlace){
 	fa::Automaton fa;
 	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(fa,5,tab);
-	
-	fa.setStateFinal(0);
-	EXPECT_TRUE(fa.addTransition(0,'a',2));
-	EXPECT_TRUE(fa.isValid());
-	EXPECT_TRUE(fa.isLanguageEmpty());
-}
+	createAutomaton(fa,3,tab);
 
-TEST(isLanguageEmpty, validNoFinalState){
-	fa::Automaton fa;
-	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(fa,5,tab);
-	
 	fa.setStateInitial(0);
-	EXPECT_TRUE(fa.addTransition(0,'a',3));
-	EXPECT_TRUE(fa.isValid());
-	EXPECT_TRUE(fa.isLanguageEmpty());
-}
+	fa.setStateFinal(2);
 
-TEST(isLanguageEmpty, validNoTransitionToFinalState){
-	fa::Automaton fa;
-	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(fa,5,tab);
-	
-	fa.setStateFinal(1);
-	fa.setStateInitial(0);
-	EXPECT_TRUE(fa.addTransition(0,'a',3));
-	EXPECT_TRUE(fa.isValid());
-	EXPECT_TRUE(fa.isLanguageEmpty());
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+	EXPECT_TRUE(fa.addTransition(2,'b',0));
+
+	fa.mirror();
+
+	EXPECT_TRUE(fa.isStateInitial(2));
+	EXPECT_TRUE(fa.isStateFinal(0));
+	EXPECT_FALSE(fa.isStateInitial(0));
+	EXPECT_TRUE(fa.hasTransition(2,'b',1));
+	EXPECT_TRUE(fa.hasTransition(0,'b',2));
+	EXPECT_EQ(4u,fa.countTransitions());
+	EXPECT_TRUE(fa.match("ba"));
+	EXPECT_TRUE(fa.match("a"));
+	EXPECT_FALSE(fa.match("ab"));
 }
 
-TEST(isLanguageEmpty, noValid){
-	fa::Automaton fa;
+/*
+ * createUnion
+ */
+static void createWord(fa::Automaton& fa, const std::string& word){
 	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(fa,5,tab);
-	
+	createAutomaton(fa,word.size() + 1,tab);
 	fa.setStateInitial(0);
-	fa.setStateFinal(1);
-	EXPECT_TRUE(fa.addTransition(0,'a',0));
-	EXPECT_TRUE(fa.addTransition(0,'b',1));
-	EXPECT_TRUE(fa.isValid());
-	EXPECT_FALSE(fa.isLanguageEmpty());
+	fa.setStateFinal(word.size());
+	for(std::size_t i = 0; i < word.size(); ++i){
+		EXPECT_TRUE(fa.addTransition(i,word[i],i + 1));
+	}
 }
 
-TEST(isLanguageEmpty, noValidAutomateExem){
-	fa::Automaton fa;
-	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(fa,8,tab);
-	
-	fa.setStateInitial(0);
-	fa.setStateInitial(2);
-	fa.setStateFinal(4);
-	fa.setStateFinal(5);
-	
-	EXPECT_TRUE(fa.addTransition(0,'a',1));
-	EXPECT_TRUE(fa.addTransition(1,'b',2));
-	EXPECT_TRUE(fa.addTransition(2,'a',4));
-	EXPECT_TRUE(fa.addTransition(3,'a',5));
-	EXPECT_TRUE(fa.addTransition(3,'b',6));
-	EXPECT_TRUE(fa.addTransition(4,'a',3));
-	EXPECT_TRUE(fa.addTransition(4,'a',7));
-	EXPECT_TRUE(fa.addTransition(4,'b',2));
-	EXPECT_TRUE(fa.addTransition(4,'b',7));
-	EXPECT_TRUE(fa.addTransition(5,'a',1));
-	EXPECT_TRUE(fa.addTransition(7,'a',4));
+TEST(createUnion, TwoWords){
+	fa::Automaton lhs, rhs;
+	createWord(lhs,"ab");
+	createWord(rhs,"ba");
+
+	fa::Automaton fa = fa::Automaton::createUnion(lhs,rhs);
 
 	EXPECT_TRUE(fa.isValid());
-	EXPECT_FALSE(fa.isLanguageEmpty());
+	EXPECT_FALSE(fa.hasEpsilonTransition());
+	EXPECT_EQ(6u,fa.countStates());
+	EXPECT_EQ(4u,fa.countTransitions());
+	EXPECT_TRUE(fa.match("ab"));
+	EXPECT_TRUE(fa.match("ba"));
+	EXPECT_FALSE(fa.match("aa"));
 }
 
-TEST(isLanguageEmpty, initialStateIsFinal){
-	fa::Automaton fa;
-	static const std::vector<char> tab = {'a','b','c'};
-	createAutomaton(fa,3,tab);
-
-	fa.setStateInitial(0);
-	fa.setStateFinal(0);
+/*
+ * createConcatenation
+ */
+TEST(createConcatenation, TwoWords){
+	fa::Automaton lhs, rhs;
+	createWord(lhs,"ab");
+	createWord(rhs,"ba");
 
-	EXPECT_TRUE(fa.addTransition(0,'a',1));
-	EXPECT_TRUE(fa.addTransition(1,'b',1));
-	EXPECT_TRUE(fa.addTransition(1,'c',2));
-	EXPECT_TRUE(fa.addTransition(1,'c',0));
-	EXPECT_TRUE(fa.addTransition(2,'a',0));
+	fa::Automaton fa = fa::Automaton::createConcatenation(lhs,rhs);
 
 	EXPECT_TRUE(fa.isValid());
-
-	EXPECT_FALSE(fa.isLanguageEmpty());
+	EXPECT_FALSE(fa.hasEpsilonTransition());
+	EXPECT_TRUE(fa.match("abba"));
+	EXPECT_FALSE(fa.match("ab"));
+	EXPECT_FALSE(fa.match("ba"));
+	EXPECT_FALSE(fa.match("abab"));
 }
 
-TEST(isLanguageEmpty, EmptyWord){
-	fa::Automaton fa;
-	static const std::vector<char> tab = {'a','b','c'};
-	createAutomaton(fa,3,tab);
-
-	fa.setStateInitial(0);
-	fa.setStateFinal(0);
+TEST(createConcatenation, EmptyWords){
+	fa::Automaton lhs, rhs;
+	createWord(lhs,"a");
+	lhs.setStateFinal(0);
+	createWord(rhs,"b");
+	rhs.setStateFinal(0);
 
-	EXPECT_TRUE(fa.isValid());
-	EXPECT_FALSE(fa.isLanguageEmpty());
+	fa::Automaton fa = fa::Automaton::createConcatenation(lhs,rhs);
+
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_TRUE(fa.match("a"));
+	EXPECT_TRUE(fa.match("b"));
+	EXPECT_TRUE(fa.match("ab"));
+	EXPECT_FALSE(fa.match("ba"));
+}
+
+/*
+ * createKleeneStar
+ */
+TEST(createKleeneStar, Word){
+	fa::Automaton other;
+	createWord(other,"ab");
+
+	fa::Automaton fa = fa::Automaton::createKleeneStar(other);
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_FALSE(fa.hasEpsilonTransition());
+	EXPECT_EQ(4u,fa.countStates());
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_TRUE(fa.match("ab"));
+	EXPECT_TRUE(fa.match("ababab"));
+	EXPECT_FALSE(fa.match("aba"));
+	EXPECT_FALSE(fa.match("ba"));
+}
+
+/*
+ * fromRegex
+ */
+TEST(fromRegex, Glushkov){
+	fa::Automaton fa = fa::Automaton::fromRegex("(a|b)*abb");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_FALSE(fa.hasEpsilonTransition());
+	EXPECT_EQ(2u,fa.countSymbols());
+	// one state by position, and the initial one
+	EXPECT_EQ(6u,fa.countStates());
+	EXPECT_TRUE(fa.isStateInitial(0));
+	EXPECT_TRUE(fa.match("abb"));
+	EXPECT_TRUE(fa.match("babaabb"));
+	EXPECT_FALSE(fa.match("abba"));
+	EXPECT_FALSE(fa.match(""));
+}
+
+TEST(fromRegex, ClassesAndRepetitions){
+	fa::Automaton fa = fa::Automaton::fromRegex("[a-c]{2,3}\\d+(x|y)?");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.match("ab0"));
+	EXPECT_TRUE(fa.match("abc123x"));
+	EXPECT_FALSE(fa.match("a1"));
+	EXPECT_FALSE(fa.match("abca1"));
+	EXPECT_FALSE(fa.match("ab"));
+	EXPECT_FALSE(fa.match("ab1xy"));
+
+	fa::Automaton other = fa::Automaton::fromRegex("[^a].");
+	EXPECT_TRUE(other.match("b!"));
+	EXPECT_TRUE(other.match("~a"));
+	EXPECT_FALSE(other.match("ab"));
+}
+
+TEST(fromRegex, EmptyWord){
+	fa::Automaton fa = fa::Automaton::fromRegex("(a|)b*");
+
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_TRUE(fa.match("a"));
+	EXPECT_TRUE(fa.match("bb"));
+	EXPECT_FALSE(fa.match("aa"));
+}
+
+TEST(fromRegex, SyntaxError){
+	EXPECT_FALSE(fa::Automaton::fromRegex("(ab").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("ab)").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("*a").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("a{3,1}").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("[]").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("a b").isValid());
+}
+
+TEST(fromRegex, Escapes){
+	fa::Automaton fa = fa::Automaton::fromRegex("\\(\\.\\-\\\\");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.match("(.-\\"));
+	EXPECT_FALSE(fa::Automaton::fromRegex("\\s\\n").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("[\\t]").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("a\\").isValid());
+}
+
+TEST(fromRegex, TooLarge){
+	fa::Automaton fa = fa::Automaton::fromRegex("((a{30}){30}){30}");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_EQ(27001u,fa.countStates());
+	EXPECT_FALSE(fa::Automaton::fromRegex("((a{1000}){1000}){1000}").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("((((){1000}){1000}){1000})").isValid());
+}
+
+TEST(fromRegex, NullableChain){
+	fa::Automaton fa = fa::Automaton::fromRegex("(a?){100}");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_EQ(101u,fa.countStates());
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_TRUE(fa.match(std::string(100,'a')));
+	EXPECT_FALSE(fa.match(std::string(101,'a')));
+	EXPECT_FALSE(fa::Automaton::fromRegex("((a?){1000}){20}").isValid());
+	EXPECT_FALSE(fa::Automaton::fromRegex("(.?){1000}").isValid());
+}
+
+/*
+ * LazyRegex
+ */
+TEST(LazyRegex, DeriveOnDemand){
+	fa::LazyRegex regex("(a|b)*abb");
+
+	EXPECT_TRUE(regex.isValid());
+	EXPECT_EQ(1u,regex.countStates());
+	EXPECT_TRUE(regex.match("abb"));
+	std::size_t derived = regex.countStates();
+	EXPECT_TRUE(regex.match("abb"));
+	EXPECT_EQ(derived,regex.countStates());
+	EXPECT_TRUE(regex.match("babaabb"));
+	EXPECT_FALSE(regex.match("abba"));
+	EXPECT_FALSE(regex.match("abc"));
+}
+
+TEST(LazyRegex, ToAutomaton){
+	fa::LazyRegex regex("(a|b)*abb");
+
+	fa::Automaton fa = regex.toAutomaton();
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isDeterministic());
+	EXPECT_TRUE(fa.isComplete());
+	EXPECT_EQ(4u,fa.countStates());
+	EXPECT_TRUE(fa.match("aabb"));
+	EXPECT_FALSE(fa.match("ab"));
+}
+
+TEST(LazyRegex, SyntaxError){
+	fa::LazyRegex regex("a|(b");
+
+	EXPECT_FALSE(regex.isValid());
+	EXPECT_FALSE(regex.match("a"));
+	EXPECT_FALSE(regex.toAutomaton().isValid());
+	EXPECT_FALSE(fa::LazyRegex("\\s").isValid());
+	EXPECT_FALSE(fa::LazyRegex("((a{1000}){1000}){1000}").isValid());
+}
+
+TEST(LazyRegex, NullableChain){
+	fa::LazyRegex bosch("((a?){1000}){20}");
+
+	EXPECT_TRUE(bosch.match(""));
+	EXPECT_TRUE(bosch.match(std::string(50,'a')));
+	EXPECT_FALSE(bosch.match("ab"));
+	EXPECT_TRUE(bosch.isValid());
+	EXPECT_EQ(1002u,fa::LazyRegex("(a?){1000}").toAutomaton().countStates());
+
+	// derived without recursing along the chain, until the budget is spent
+	fa::LazyRegex glados("((a?){1000}){100}");
+	EXPECT_TRUE(glados.isValid());
+	EXPECT_FALSE(glados.match(std::string(50,'a')));
+	EXPECT_FALSE(glados.isValid());
+	EXPECT_FALSE(glados.toAutomaton().isValid());
+}
+
+/*
+ * fromSortedWords
+ */
+TEST(fromSortedWords, SharedSuffixes){
+	std::vector<std::string> words = {"tap","taps","top","tops"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isDeterministic());
+	EXPECT_EQ(5u,fa.countStates());
+	EXPECT_EQ(5u,fa.countTransitions());
+	EXPECT_TRUE(fa.match("tap"));
+	EXPECT_TRUE(fa.match("tops"));
+	EXPECT_FALSE(fa.match("ta"));
+	EXPECT_FALSE(fa.match("topss"));
+}
+
+TEST(fromSortedWords, SameAsMinimal){
+	std::vector<std::string_view> words = {"","ab","abab","abc","b","bab","babc","bc","c"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+	fa::Automaton bosch = fa::Automaton::createMinimalValmari(fa);
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_EQ(bosch.countStates(),fa.countStates());
+	EXPECT_EQ(bosch.countTransitions(),fa.countTransitions());
+}
+
+TEST(fromSortedWords, Duplicates){
+	std::vector<std::string> words = {"a","a","ab","ab"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_EQ(3u,fa.countStates());
+	EXPECT_TRUE(fa.match("a"));
+	EXPECT_TRUE(fa.match("ab"));
+}
+
+TEST(fromSortedWords, Unsorted){
+	std::vector<std::string> words = {"b","a"};
+	EXPECT_FALSE(fa::Automaton::fromSortedWords(words.begin(),words.end()).isValid());
+
+	std::vector<std::string> spaces = {"a b"};
+	EXPECT_FALSE(fa::Automaton::fromSortedWords(spaces.begin(),spaces.end()).isValid());
+}
+
+/*
+ * wordToIndex, indexToWord
+ */
+TEST(wordToIndex, Dictionary){
+	std::vector<std::string> words = {"","bar","baz","foo","foobar","fool"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+
+	EXPECT_EQ(words.size(),fa.countWords());
+	for(std::size_t i = 0; i < words.size(); ++i){
+		EXPECT_EQ(std::optional<std::size_t>(i),fa.wordToIndex(words[i]));
+		EXPECT_EQ(std::optional<std::string>(words[i]),fa.indexToWord(i));
+	}
+	EXPECT_FALSE(fa.wordToIndex("fo"));
+	EXPECT_FALSE(fa.wordToIndex("fools"));
+	EXPECT_FALSE(fa.indexToWord(words.size()));
+}
+
+TEST(wordToIndex, UpdatedAfterModification){
+	std::vector<std::string> words = {"a","b"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+	fa::Automaton bosch = fa;
+
+	EXPECT_EQ(std::optional<std::size_t>(1),fa.wordToIndex("b"));
+	fa.setStateFinal(0);
+	EXPECT_EQ(std::optional<std::size_t>(2),fa.wordToIndex("b"));
+	EXPECT_EQ(std::optional<std::string>(""),fa.indexToWord(0));
+	EXPECT_EQ(2u,bosch.countWords());
+}
+
+static void createChain(fa::Automaton& fa, int length){
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,length + 1,tab);
+	fa.setStateInitial(0);
+	fa.setStateFinal(length);
+	for(int i = 0; i < length; ++i){
+		EXPECT_TRUE(fa.addTransition(i,'a',i + 1));
+		EXPECT_TRUE(fa.addTransition(i,'b',i + 1));
+	}
+}
+
+TEST(wordToIndex, TooManyWords){
+	fa::Automaton fa;
+	createChain(fa,63);
+
+	EXPECT_EQ(std::size_t(1) << 63,fa.countWords());
+	EXPECT_EQ(std::optional<std::size_t>((std::size_t(1) << 63) - 1),fa.wordToIndex(std::string(63,'b')));
+	EXPECT_EQ(std::optional<std::string>(std::string(61,'a') + "ba"),fa.indexToWord(2));
+
+	fa::Automaton bosch;
+	createChain(bosch,70);
+
+	EXPECT_EQ(0u,bosch.countWords());
+	EXPECT_FALSE(bosch.wordToIndex(std::string(70,'b')));
+	EXPECT_FALSE(bosch.indexToWord(5));
+}
+
+TEST(wordToIndex, Cyclic){
+	fa::Automaton fa;
+	fa.addSymbol('a');
+	fa.addState(0);
+	fa.setStateInitial(0);
+	fa.setStateFinal(0);
+	fa.addTransition(0,'a',0);
+
+	EXPECT_EQ(0u,fa.countWords());
+	EXPECT_FALSE(fa.wordToIndex("a"));
+	EXPECT_FALSE(fa.indexToWord(0));
+}
+
+/*
+ * createSuffixAutomaton
+ */
+TEST(createSuffixAutomaton, Substrings){
+	fa::Automaton fa = fa::Automaton::createSuffixAutomaton("abcbc");
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isDeterministic());
+	EXPECT_LE(fa.countStates(),9u);
+	EXPECT_TRUE(fa.match(""));
+	EXPECT_TRUE(fa.match("bcb"));
+	EXPECT_TRUE(fa.match("abcbc"));
+	EXPECT_FALSE(fa.match("cc"));
+	EXPECT_FALSE(fa.match("abcbcb"));
+}
+
+TEST(createSuffixAutomaton, Occurrences){
+	std::vector<std::size_t> occurrences;
+	fa::Automaton fa = fa::Automaton::createSuffixAutomaton("abababa",&occurrences);
+
+	EXPECT_EQ(fa.countStates(),occurrences.size());
+	EXPECT_EQ(4u,occurrences[*fa.readString("a").begin()]);
+	EXPECT_EQ(3u,occurrences[*fa.readString("aba").begin()]);
+	EXPECT_EQ(3u,occurrences[*fa.readString("ba").begin()]);
+	EXPECT_EQ(1u,occurrences[*fa.readString("abababa").begin()]);
+}
+
+TEST(createSuffixAutomaton, InvalidText){
+	EXPECT_FALSE(fa::Automaton::createSuffixAutomaton("two words").isValid());
+	EXPECT_TRUE(fa::Automaton::createSuffixAutomaton("").isValid());
+}
+
+/*
+ * BackwardMatcher
+ */
+TEST(BackwardMatcher, Words){
+	std::vector<std::string> words = {"needle","noodle"};
+	fa::Automaton fa = fa::Automaton::fromSortedWords(words.begin(),words.end());
+	fa::BackwardMatcher matcher(fa);
+
+	EXPECT_TRUE(matcher.isValid());
+	EXPECT_EQ(6u,matcher.getWindow());
+	EXPECT_EQ(std::vector<std::size_t>({3,17}),matcher.search("xx noodle in the needle stack"));
+	EXPECT_TRUE(matcher.search("no needles there, only noodl").size() == 1);
+	EXPECT_TRUE(matcher.search("need").empty());
+}
+
+TEST(BackwardMatcher, Language){
+	fa::Automaton fa = fa::Automaton::fromRegex("ab+c");
+	fa::BackwardMatcher matcher(fa);
+
+	EXPECT_EQ(3u,matcher.getWindow());
+	EXPECT_EQ(std::vector<std::size_t>({0,6,9}),matcher.search("abbbcxabcabc_ab"));
+}
+
+TEST(BackwardMatcher, ManyStates){
+	std::string word;
+	for(int i = 0; i < 100; ++i){
+		word += (char)('a' + i % 7);
+	}
+	std::vector<std::string> words = {word};
+	fa::BackwardMatcher matcher(fa::Automaton::fromSortedWords(words.begin(),words.end()));
+
+	EXPECT_EQ(100u,matcher.getWindow());
+	EXPECT_EQ(std::vector<std::size_t>({2}),matcher.search("gg" + word + "abc"));
+	EXPECT_TRUE(matcher.search(word.substr(1)).empty());
+}
+
+TEST(BackwardMatcher, Invalid){
+	fa::BackwardMatcher matcher((fa::Automaton()));
+
+	EXPECT_FALSE(matcher.isValid());
+	EXPECT_TRUE(matcher.search("abc").empty());
+}
+
+/**
+ * isLanguageEmpty
+ */ 
+TEST(isLanguageEmpty, validNoInitialState){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+	
+	fa.setStateFinal(0);
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, validNoFinalState){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+	
+	fa.setStateInitial(0);
+	EXPECT_TRUE(fa.addTransition(0,'a',3));
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, validNoTransitionToFinalState){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+	
+	fa.setStateFinal(1);
+	fa.setStateInitial(0);
+	EXPECT_TRUE(fa.addTransition(0,'a',3));
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, noValid){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+	
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	EXPECT_TRUE(fa.addTransition(0,'a',0));
+	EXPECT_TRUE(fa.addTransition(0,'b',1));
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_FALSE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, noValidAutomateExem){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,8,tab);
+	
+	fa.setStateInitial(0);
+	fa.setStateInitial(2);
+	fa.setStateFinal(4);
+	fa.setStateFinal(5);
+	
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+	EXPECT_TRUE(fa.addTransition(2,'a',4));
+	EXPECT_TRUE(fa.addTransition(3,'a',5));
+	EXPECT_TRUE(fa.addTransition(3,'b',6));
+	EXPECT_TRUE(fa.addTransition(4,'a',3));
+	EXPECT_TRUE(fa.addTransition(4,'a',7));
+	EXPECT_TRUE(fa.addTransition(4,'b',2));
+	EXPECT_TRUE(fa.addTransition(4,'b',7));
+	EXPECT_TRUE(fa.addTransition(5,'a',1));
+	EXPECT_TRUE(fa.addTransition(7,'a',4));
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_FALSE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, initialStateIsFinal){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b','c'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(0);
+
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'b',1));
+	EXPECT_TRUE(fa.addTransition(1,'c',2));
+	EXPECT_TRUE(fa.addTransition(1,'c',0));
+	EXPECT_TRUE(fa.addTransition(2,'a',0));
+
+	EXPECT_TRUE(fa.isValid());
+
+	EXPECT_FALSE(fa.isLanguageEmpty());
+}
+
+TEST(isLanguageEmpty, EmptyWord){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b','c'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(0);
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_FALSE(fa.isLanguageEmpty());
 
 }
 
@@ -1447,21 +2160,195 @@ TEST(createProduct,LoopOnExistingState){
 }
 
 /*
- * hasEmptyIntersectionWith
+ * createProductParallel
  */
-
-
-TEST(hasEmptyIntersectionWith,sameAutomate){
+TEST(createProductParallel,SameAsSequential){
 	fa::Automaton lhs;
 	static const std::vector<char> tab = {'a','b'};
-	createAutomaton(lhs,2,tab);
-	
+	createAutomaton(lhs,3,tab);
+
 	lhs.setStateInitial(0);
-	lhs.setStateFinal(1);
-	
-	EXPECT_TRUE(lhs.addTransition(0,'a',1));
+	lhs.setStateInitial(1);
+	lhs.setStateFinal(2);
 	EXPECT_TRUE(lhs.addTransition(0,'b',1));
-	EXPECT_TRUE(lhs.addTransition(1,'a',1));
+	EXPECT_TRUE(lhs.addTransition(0,'b',2));
+	EXPECT_TRUE(lhs.addTransition(1,'a',2));
+	EXPECT_TRUE(lhs.addTransition(2,'b',2));
+	EXPECT_TRUE(lhs.addTransition(2,'a',0));
+
+	fa::Automaton rhs;
+	createAutomaton(rhs,4,tab);
+
+	rhs.setStateInitial(0);
+	rhs.setStateFinal(2);
+	rhs.setStateFinal(3);
+	EXPECT_TRUE(rhs.addTransition(0,'b',0));
+	EXPECT_TRUE(rhs.addTransition(0,'a',1));
+	EXPECT_TRUE(rhs.addTransition(1,'b',2));
+	EXPECT_TRUE(rhs.addTransition(1,'a',3));
+	EXPECT_TRUE(rhs.addTransition(3,'a',0));
+	EXPECT_TRUE(rhs.addTransition(2,'b',3));
+
+	fa::Automaton product = fa::Automaton::createProduct(lhs,rhs);
+	for(unsigned threads : {2u,3u,4u}){
+		fa::Automaton fa = fa::Automaton::createProductParallel(lhs,rhs,threads);
+
+		EXPECT_EQ(product.countStates(),fa.countStates());
+		EXPECT_EQ(product.countTransitions(),fa.countTransitions());
+		for(int from = 0; from < (int)fa.countStates(); ++from){
+			EXPECT_EQ(product.isStateInitial(from),fa.isStateInitial(from));
+			EXPECT_EQ(product.isStateFinal(from),fa.isStateFinal(from));
+			for(int to = 0; to < (int)fa.countStates(); ++to){
+				EXPECT_EQ(product.hasTransition(from,'a',to),fa.hasTransition(from,'a',to));
+				EXPECT_EQ(product.hasTransition(from,'b',to),fa.hasTransition(from,'b',to));
+			}
+		}
+		EXPECT_TRUE(fa.match("bab"));
+	}
+}
+
+TEST(createProductParallel,EmptyProduct){
+	fa::Automaton lhs;
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(lhs,1,tab);
+
+	fa::Automaton rhs;
+	static const std::vector<char> tab2 = {'b'};
+	createAutomaton(rhs,1,tab2);
+	rhs.setStateInitial(0);
+
+	fa::Automaton fa = fa::Automaton::createProductParallel(lhs,rhs,4);
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isLanguageEmpty());
+}
+
+/*
+ * createProduct of many automata
+ */
+static void createContains(fa::Automaton& fa, char letter){
+	static const std::vector<char> tab = {'a','b','c'};
+	createAutomaton(fa,2,tab);
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	for(char a : tab){
+		EXPECT_TRUE(fa.addTransition(0,a,a == letter ? 1 : 0));
+		EXPECT_TRUE(fa.addTransition(1,a,1));
+	}
+}
+
+TEST(createProductMany,ThreeAutomata){
+	std::vector<fa::Automaton> automata(3);
+	createContains(automata[0],'a');
+	createContains(automata[1],'b');
+	createContains(automata[2],'c');
+
+	for(auto order : {fa::ProductOrder::Smallest,fa::ProductOrder::AlphabetOverlap}){
+		for(unsigned threads : {1u,3u}){
+			fa::ProductOptions options;
+			options.order = order;
+			options.threads = threads;
+			fa::Automaton fa = fa::Automaton::createProduct(automata,options);
+
+			EXPECT_TRUE(fa.isValid());
+			EXPECT_TRUE(fa.isDeterministic());
+			EXPECT_EQ(8u,fa.countStates());
+			EXPECT_TRUE(fa.match("cab"));
+			EXPECT_TRUE(fa.match("aabbcc"));
+			EXPECT_FALSE(fa.match("abab"));
+		}
+	}
+}
+
+TEST(createProductMany,EmptyIntersection){
+	std::vector<fa::Automaton> automata(3);
+	createContains(automata[0],'a');
+	createContains(automata[1],'b');
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(automata[2],1,tab);
+	automata[2].setStateInitial(0);
+	automata[2].setStateFinal(0);
+	EXPECT_TRUE(automata[2].addTransition(0,'a',0));
+
+	fa::Automaton fa = fa::Automaton::createProduct(automata);
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isLanguageEmpty());
+	EXPECT_EQ(2u,fa.countSymbols());
+}
+
+static void createCount(fa::Automaton& fa, const std::vector<char>& tab, char letter, int modulo, int remainder){
+	createAutomaton(fa,modulo,tab);
+	fa.setStateInitial(0);
+	fa.setStateFinal(remainder);
+	for(int i = 0; i < modulo; ++i){
+		for(char a : tab){
+			EXPECT_TRUE(fa.addTransition(i,a,a == letter ? (i + 1) % modulo : i));
+		}
+	}
+}
+
+TEST(createProductMany,OrderChangesIntermediateProducts){
+	// the last one shares no symbol with the others, and does not accept the empty word
+	std::vector<fa::Automaton> automata(3);
+	createCount(automata[0],{'a','b'},'a',4,0);
+	createCount(automata[1],{'a','b'},'b',5,0);
+	createCount(automata[2],{'c'},'c',6,1);
+
+	fa::ProductStats stats;
+	fa::ProductOptions options;
+	options.stats = &stats;
+	fa::Automaton fa = fa::Automaton::createProduct(automata,options);
+
+	EXPECT_TRUE(fa.isLanguageEmpty());
+	EXPECT_EQ(20u,stats.largestProduct);
+
+	options.order = fa::ProductOrder::AlphabetOverlap;
+	fa = fa::Automaton::createProduct(automata,options);
+
+	EXPECT_TRUE(fa.isLanguageEmpty());
+	EXPECT_EQ(1u,stats.products);
+	EXPECT_EQ(1u,stats.largestProduct);
+}
+
+TEST(createProductMany,NonDeterministicWithoutMinimization){
+	std::vector<fa::Automaton> automata(2);
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(automata[0],3,tab);
+	automata[0].setStateInitial(0);
+	automata[0].setStateFinal(1);
+	EXPECT_TRUE(automata[0].addTransition(0,'a',0));
+	EXPECT_TRUE(automata[0].addTransition(0,'a',1));
+	EXPECT_TRUE(automata[0].addTransition(0,'b',0));
+	EXPECT_TRUE(automata[0].addTransition(2,'a',2));
+	createContains(automata[1],'b');
+
+	fa::ProductOptions options;
+	options.minimize = false;
+	fa::Automaton fa = fa::Automaton::createProduct(automata,options);
+
+	EXPECT_FALSE(fa.isDeterministic());
+	EXPECT_TRUE(fa.match("ba"));
+	EXPECT_TRUE(fa.match("aaba"));
+	EXPECT_FALSE(fa.match("ab"));
+}
+
+/*
+ * hasEmptyIntersectionWith
+ */
+
+
+TEST(hasEmptyIntersectionWith,sameAutomate){
+	fa::Automaton lhs;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(lhs,2,tab);
+	
+	lhs.setStateInitial(0);
+	lhs.setStateFinal(1);
+	
+	EXPECT_TRUE(lhs.addTransition(0,'a',1));
+	EXPECT_TRUE(lhs.addTransition(0,'b',1));
+	EXPECT_TRUE(lhs.addTransition(1,'a',1));
 	EXPECT_TRUE(lhs.isValid());
 
 	fa::Automaton rhs = lhs;
@@ -2003,6 +2890,99 @@ TEST(createDeterministic,alreadyDeterministic){
 
 }
 
+TEST(determinize,InPlace){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateInitial(1);
+	fa.setStateFinal(2);
+
+	EXPECT_TRUE(fa.addTransition(0,'a',0));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+
+	fa.determinize();
+
+	EXPECT_TRUE(fa.isValid());
+	EXPECT_TRUE(fa.isDeterministic());
+	EXPECT_TRUE(fa.match("a"));
+	EXPECT_TRUE(fa.match("aaa"));
+	EXPECT_TRUE(fa.match("b"));
+	EXPECT_FALSE(fa.match("ab"));
+}
+
+TEST(createDeterministic,Rvalue){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(fa,2,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	EXPECT_TRUE(fa.addTransition(0,'a',0));
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+
+	fa::Automaton det = fa::Automaton::createDeterministic(std::move(fa));
+
+	EXPECT_TRUE(det.isDeterministic());
+	EXPECT_TRUE(det.match("aa"));
+	EXPECT_FALSE(det.match(""));
+}
+
+/*
+ * createDeterministicParallel
+ */
+TEST(createDeterministicParallel,SameAsSequential){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+
+	// the fourth letter from the end is an a
+	fa.setStateInitial(0);
+	fa.setStateFinal(4);
+	EXPECT_TRUE(fa.addTransition(0,'a',0));
+	EXPECT_TRUE(fa.addTransition(0,'b',0));
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	for(int i = 1; i < 4; ++i){
+		EXPECT_TRUE(fa.addTransition(i,'a',i + 1));
+		EXPECT_TRUE(fa.addTransition(i,'b',i + 1));
+	}
+
+	fa::Automaton det = fa::Automaton::createDeterministic(fa);
+	for(unsigned threads : {2u,3u,4u}){
+		fa::Automaton faa = fa::Automaton::createDeterministicParallel(fa,threads);
+
+		EXPECT_TRUE(faa.isDeterministic());
+		EXPECT_EQ(16u,faa.countStates());
+		EXPECT_EQ(det.countTransitions(),faa.countTransitions());
+		for(int from = 0; from < 16; ++from){
+			EXPECT_EQ(det.isStateFinal(from),faa.isStateFinal(from));
+			for(int to = 0; to < 16; ++to){
+				EXPECT_EQ(det.hasTransition(from,'a',to),faa.hasTransition(from,'a',to));
+				EXPECT_EQ(det.hasTransition(from,'b',to),faa.hasTransition(from,'b',to));
+			}
+		}
+		EXPECT_TRUE(faa.match("abbb"));
+		EXPECT_FALSE(faa.match("babb"));
+	}
+}
+
+TEST(createDeterministicParallel,alreadyDeterministic){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(fa,2,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+
+	fa::Automaton faa = fa::Automaton::createDeterministicParallel(fa,4);
+
+	EXPECT_EQ(2u,faa.countStates());
+	EXPECT_TRUE(faa.hasTransition(0,'a',1));
+}
+
 /*
  * isIncludedIn
  */
@@ -2290,6 +3270,502 @@ TEST(createMinimalBrzozowski,td5ex17AlreadyCompletAndDeterministic){
 }
 
 
+TEST(createMinimalBrzozowski,DeterministicMirrorWithDeadState){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'b',2));
+
+	fa::Automaton faa = fa.createMinimalBrzozowski(fa);
+
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.match("a"));
+	EXPECT_FALSE(faa.match("b"));
+	EXPECT_FALSE(faa.match("aa"));
+}
+
+TEST(createMinimalBrzozowski,Rvalue){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	fa.setStateFinal(2);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',1));
+	EXPECT_TRUE(fa.addTransition(2,'b',2));
+
+	fa::Automaton copy = fa;
+	fa::Automaton faa = fa::Automaton::createMinimalBrzozowski(std::move(fa));
+
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.isIncludedIn(copy));
+	EXPECT_TRUE(copy.isIncludedIn(faa));
+}
+
+
+/*
+ * createMinimalHopcroft
+ */
+TEST(createMinimalHopcroft,td5ex17AlreadyCompletAndDeterministic){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,6,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(4);
+	fa.setStateFinal(5);
+
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'a',0));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+	EXPECT_TRUE(fa.addTransition(2,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'b',3));
+	EXPECT_TRUE(fa.addTransition(3,'a',1));
+	EXPECT_TRUE(fa.addTransition(3,'b',4));
+	EXPECT_TRUE(fa.addTransition(4,'b',4));
+	EXPECT_TRUE(fa.addTransition(4,'a',0));
+	EXPECT_TRUE(fa.addTransition(2,'b',5));
+	EXPECT_TRUE(fa.addTransition(5,'a',1));
+	EXPECT_TRUE(fa.addTransition(5,'b',4));
+
+	fa::Automaton faa = fa::Automaton::createMinimalHopcroft(fa);
+
+	EXPECT_TRUE(faa.isValid());
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.isStateInitial(0));
+	EXPECT_TRUE(fa.isIncludedIn(faa));
+	EXPECT_TRUE(faa.isIncludedIn(fa));
+}
+
+TEST(createMinimalHopcroft,NonDeterministic){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,4,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateInitial(1);
+	fa.setStateFinal(2);
+	fa.setStateFinal(3);
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'a',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',2));
+	EXPECT_TRUE(fa.addTransition(3,'b',3));
+
+	fa::Automaton faa = fa::Automaton::createMinimalHopcroft(fa);
+
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.match("abbb"));
+	EXPECT_FALSE(faa.match("b"));
+}
+
+/*
+ * createMinimalParallel
+ */
+TEST(createMinimalParallel,SameAsHopcroft){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,6,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(4);
+	fa.setStateFinal(5);
+
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'a',0));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+	EXPECT_TRUE(fa.addTransition(2,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'b',3));
+	EXPECT_TRUE(fa.addTransition(3,'a',1));
+	EXPECT_TRUE(fa.addTransition(3,'b',4));
+	EXPECT_TRUE(fa.addTransition(4,'b',4));
+	EXPECT_TRUE(fa.addTransition(4,'a',0));
+	EXPECT_TRUE(fa.addTransition(2,'b',5));
+	EXPECT_TRUE(fa.addTransition(5,'a',1));
+	EXPECT_TRUE(fa.addTransition(5,'b',4));
+
+	fa::Automaton hop = fa::Automaton::createMinimalHopcroft(fa);
+	for(unsigned threads : {1u,2u,4u}){
+		fa::Automaton faa = fa::Automaton::createMinimalParallel(fa,threads);
+
+		EXPECT_TRUE(faa.isComplete());
+		EXPECT_TRUE(faa.isDeterministic());
+		EXPECT_EQ(3u,faa.countStates());
+		for(int from = 0; from < 3; ++from){
+			EXPECT_EQ(hop.isStateFinal(from),faa.isStateFinal(from));
+			for(int to = 0; to < 3; ++to){
+				EXPECT_EQ(hop.hasTransition(from,'a',to),faa.hasTransition(from,'a',to));
+				EXPECT_EQ(hop.hasTransition(from,'b',to),faa.hasTransition(from,'b',to));
+			}
+		}
+	}
+}
+
+TEST(createMinimalParallel,NonDeterministic){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,4,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateInitial(1);
+	fa.setStateFinal(2);
+	fa.setStateFinal(3);
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'a',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',2));
+	EXPECT_TRUE(fa.addTransition(3,'b',3));
+
+	fa::MinimizeStats stats;
+	fa::MinimizeOptions options;
+	options.algorithm = fa::MinimizeAlgorithm::Parallel;
+	options.threads = 3;
+	options.stats = &stats;
+	fa::Automaton faa = fa::Automaton::createMinimal(fa,options);
+
+	EXPECT_EQ(fa::MinimizeAlgorithm::Parallel,stats.algorithm);
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.match("abbb"));
+	EXPECT_FALSE(faa.match("b"));
+}
+
+TEST(createMinimalParallel,EpsilonEdge){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(2);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,fa::Epsilon,2));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+
+	fa::Automaton faa = fa::Automaton::createMinimalParallel(fa,1);
+	fa::Automaton bosch = fa::Automaton::createMinimalHopcroft(fa);
+
+	EXPECT_TRUE(faa.match("ab"));
+	EXPECT_FALSE(faa.match("a"));
+	EXPECT_FALSE(faa.match("bb"));
+	EXPECT_EQ(bosch.countStates(),faa.countStates());
+}
+
+/*
+ * createMinimalValmari
+ */
+TEST(createMinimalValmari,PartialResult){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b','c'};
+	createAutomaton(fa,5,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(3);
+	fa.setStateFinal(4);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'b',2));
+	EXPECT_TRUE(fa.addTransition(1,'c',3));
+	EXPECT_TRUE(fa.addTransition(2,'c',4));
+
+	fa::Automaton faa = fa::Automaton::createMinimalValmari(fa);
+
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_FALSE(faa.isComplete());
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_EQ(3u,faa.countTransitions());
+	EXPECT_TRUE(faa.match("ac"));
+	EXPECT_TRUE(faa.match("bc"));
+	EXPECT_FALSE(faa.match("cc"));
+}
+
+TEST(createMinimalValmari,DropBinState){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateInitial(1);
+	fa.setStateFinal(1);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'b',2));
+	EXPECT_TRUE(fa.addTransition(2,'a',2));
+	EXPECT_TRUE(fa.addTransition(2,'b',2));
+
+	fa::Automaton faa = fa::Automaton::createMinimalValmari(fa);
+
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_EQ(1u,faa.countStates());
+	EXPECT_EQ(1u,faa.countTransitions());
+	EXPECT_TRUE(faa.match(""));
+	EXPECT_TRUE(faa.match("aaa"));
+	EXPECT_FALSE(faa.match("ab"));
+}
+
+/*
+ * createMinimal
+ */
+TEST(createMinimal,AutoWithStats){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,3,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(1);
+	fa.setStateFinal(2);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',1));
+	EXPECT_TRUE(fa.addTransition(2,'b',2));
+
+	fa::MinimizeStats stats;
+	fa::MinimizeOptions options;
+	options.stats = &stats;
+	fa::Automaton faa = fa::Automaton::createMinimal(fa,options);
+
+	EXPECT_NE(fa::MinimizeAlgorithm::Auto,stats.algorithm);
+	EXPECT_GE(stats.seconds,0.0);
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_TRUE(faa.match("abb"));
+	EXPECT_FALSE(faa.match("ba"));
+}
+
+TEST(createMinimal,AutoIsComplete){
+	// a sparse automaton, above the size of the small automata
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b','c','d'};
+	createAutomaton(fa,100,tab);
+	fa.setStateInitial(0);
+	fa.setStateFinal(99);
+	for(int i = 0; i < 99; ++i){
+		EXPECT_TRUE(fa.addTransition(i,'a',i + 1));
+	}
+
+	fa::MinimizeStats stats;
+	fa::MinimizeOptions options;
+	options.stats = &stats;
+	fa::Automaton faa = fa::Automaton::createMinimal(fa,options);
+
+	EXPECT_EQ(fa::MinimizeAlgorithm::Hopcroft,stats.algorithm);
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_EQ(101u,faa.countStates());
+	EXPECT_TRUE(faa.match(std::string(99,'a')));
+
+	fa::Automaton bosch;
+	createAutomaton(bosch,100,tab);
+	bosch.setStateInitial(0);
+	bosch.addTransition(0,'a',1);
+	faa = fa::Automaton::createMinimal(bosch,options);
+
+	EXPECT_TRUE(faa.isComplete());
+	EXPECT_EQ(1u,faa.countStates());
+
+	// the partial automaton only when asked
+	options.algorithm = fa::MinimizeAlgorithm::Valmari;
+	faa = fa::Automaton::createMinimal(fa,options);
+
+	EXPECT_EQ(fa::MinimizeAlgorithm::Valmari,stats.algorithm);
+	EXPECT_FALSE(faa.isComplete());
+	EXPECT_EQ(100u,faa.countStates());
+}
+
+TEST(createMinimal,ChosenAlgorithm){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(fa,4,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(2);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(1,'a',2));
+	EXPECT_TRUE(fa.addTransition(2,'a',3));
+	EXPECT_TRUE(fa.addTransition(3,'a',0));
+
+	for(auto algorithm : {fa::MinimizeAlgorithm::Moore,fa::MinimizeAlgorithm::Brzozowski,fa::MinimizeAlgorithm::Hopcroft}){
+		fa::MinimizeStats stats;
+		fa::MinimizeOptions options;
+		options.algorithm = algorithm;
+		options.stats = &stats;
+		fa::Automaton faa = fa::Automaton::createMinimal(fa,options);
+		EXPECT_EQ(algorithm,stats.algorithm);
+		EXPECT_EQ(4u,faa.countStates());
+		EXPECT_TRUE(faa.match("aaaaaa"));
+		EXPECT_FALSE(faa.match("aaa"));
+	}
+}
+
+
+/*
+ * createReducedBySimulation
+ */
+TEST(createReducedBySimulation,MergeEquivalentStates){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(3);
+	fa.setStateFinal(4);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',4));
+	EXPECT_TRUE(fa.addTransition(3,'a',3));
+	EXPECT_TRUE(fa.addTransition(4,'a',4));
+
+	fa::Automaton faa = fa::Automaton::createReducedBySimulation(fa);
+
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_EQ(3u,faa.countTransitions());
+	EXPECT_TRUE(faa.hasState(0));
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_TRUE(faa.match("ab"));
+	EXPECT_TRUE(faa.match("abaa"));
+	EXPECT_FALSE(faa.match("abb"));
+}
+
+TEST(createReducedBySimulation,PruneLittleBrother){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,4,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(3);
+	// 2 can read b or a then b, 1 only b
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'a',2));
+
+	fa::Automaton faa = fa::Automaton::createReducedBySimulation(fa);
+
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_FALSE(faa.hasState(1));
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_TRUE(faa.match("ab"));
+	EXPECT_TRUE(faa.match("aaab"));
+	EXPECT_FALSE(faa.match("aba"));
+	EXPECT_TRUE(faa.isIncludedIn(fa));
+	EXPECT_TRUE(fa.isIncludedIn(faa));
+}
+
+/*
+ * createBisimulationQuotient
+ */
+TEST(createBisimulationQuotient,MergeBisimilarStates){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,5,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(3);
+	fa.setStateFinal(4);
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',4));
+	EXPECT_TRUE(fa.addTransition(3,'a',4));
+	EXPECT_TRUE(fa.addTransition(4,'a',3));
+
+	fa::Automaton faa = fa::Automaton::createBisimulationQuotient(fa);
+
+	EXPECT_EQ(3u,faa.countStates());
+	EXPECT_EQ(3u,faa.countTransitions());
+	EXPECT_TRUE(faa.hasState(0));
+	EXPECT_TRUE(faa.hasState(1));
+	EXPECT_TRUE(faa.hasState(3));
+	EXPECT_TRUE(faa.hasTransition(3,'a',3));
+	EXPECT_TRUE(faa.isDeterministic());
+	EXPECT_TRUE(faa.match("abaa"));
+	EXPECT_FALSE(faa.match("abb"));
+}
+
+TEST(createBisimulationQuotient,KeepSimilarStates){
+	fa::Automaton fa;
+	static const std::vector<char> tab = {'a','b'};
+	createAutomaton(fa,4,tab);
+
+	fa.setStateInitial(0);
+	fa.setStateFinal(3);
+	// 2 simulates 1 but they are not bisimilar
+	EXPECT_TRUE(fa.addTransition(0,'a',1));
+	EXPECT_TRUE(fa.addTransition(0,'a',2));
+	EXPECT_TRUE(fa.addTransition(1,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'b',3));
+	EXPECT_TRUE(fa.addTransition(2,'a',2));
+
+	fa::Automaton faa = fa::Automaton::createBisimulationQuotient(fa);
+
+	EXPECT_EQ(4u,faa.countStates());
+	EXPECT_EQ(5u,faa.countTransitions());
+	EXPECT_TRUE(faa.isIncludedIn(fa));
+	EXPECT_TRUE(fa.isIncludedIn(faa));
+}
+
+TEST(createBisimulationQuotient,EmptyAutomaton){
+	fa::Automaton fa;
+	fa.addSymbol('a');
+
+	fa::Automaton faa = fa::Automaton::createBisimulationQuotient(fa);
+
+	EXPECT_EQ(0u,faa.countStates());
+	EXPECT_EQ(1u,faa.countSymbols());
+}
+
+/*
+ * Scanner
+ */
+TEST(Scanner,SeveralAutomata){
+	std::vector<fa::Automaton> automata(3);
+	createContains(automata[0],'a');
+	createContains(automata[1],'b');
+	static const std::vector<char> tab = {'a'};
+	createAutomaton(automata[2],2,tab);
+	automata[2].setStateInitial(0);
+	automata[2].setStateInitial(1);
+	automata[2].setStateFinal(1);
+	EXPECT_TRUE(automata[2].addTransition(0,'a',0));
+	EXPECT_TRUE(automata[2].addTransition(1,'a',0));
+
+	fa::Scanner scanner(automata);
+
+	EXPECT_EQ(3u,scanner.countAutomata());
+	EXPECT_EQ(std::vector<std::uint64_t>({0b100}),scanner.match(""));
+	EXPECT_EQ(std::vector<std::uint64_t>({0b001}),scanner.match("a"));
+	EXPECT_EQ(std::vector<std::uint64_t>({0b011}),scanner.match("cab"));
+	EXPECT_EQ(std::vector<std::uint64_t>({0b000}),scanner.match("z"));
+}
+
+TEST(Scanner,ManyAutomata){
+	std::vector<fa::Automaton> automata(100);
+	for(std::size_t i = 0; i < automata.size(); ++i){
+		createContains(automata[i],"abc"[i % 3]);
+	}
+
+	fa::Scanner scanner(automata);
+	std::vector<std::uint64_t> accepted = scanner.match("bcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbcbc");
+
+	EXPECT_EQ(100u,scanner.countAutomata());
+	ASSERT_EQ(2u,accepted.size());
+	for(std::size_t i = 0; i < automata.size(); ++i){
+		EXPECT_EQ(i % 3 != 0,(accepted[i / 64] >> (i % 64)) & 1);
+	}
+}
+
+
 /*
  * prettyPrint modelisation
  */